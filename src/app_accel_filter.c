@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_accel_filter.h"
+
+#include <errno.h>
+#include <math.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_APP_ACCEL_FILTER_BENCHMARK)
+#include <zephyr/timing/timing.h>
+#endif
+
+LOG_MODULE_REGISTER(app_accel_filter, CONFIG_APP_LOG_LEVEL);
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Quality factor of a 2nd-order Butterworth section */
+#define BUTTERWORTH_Q 0.70710678f
+
+int app_accel_filter_init(struct app_accel_filter *filter, float sample_rate_hz,
+			  float cutoff_hz)
+{
+	float w0;
+	float alpha;
+	float cos_w0;
+	float a0;
+
+	if (cutoff_hz <= 0.0f || cutoff_hz >= sample_rate_hz / 2.0f) {
+		LOG_ERR("Invalid filter cutoff %.3f Hz for sample rate %.3f Hz",
+			(double)cutoff_hz, (double)sample_rate_hz);
+		return -EINVAL;
+	}
+
+	/* Bilinear transform low-pass biquad (RBJ audio EQ cookbook) */
+	w0 = 2.0f * (float)M_PI * cutoff_hz / sample_rate_hz;
+	cos_w0 = cosf(w0);
+	alpha = sinf(w0) / (2.0f * BUTTERWORTH_Q);
+	a0 = 1.0f + alpha;
+
+	for (int i = 0; i < APP_ACCEL_FILTER_STAGES; i++) {
+		float32_t *c = &filter->coeffs[5 * i];
+
+		c[0] = ((1.0f - cos_w0) / 2.0f) / a0;
+		c[1] = (1.0f - cos_w0) / a0;
+		c[2] = c[0];
+		/* CMSIS-DSP expects the feedback coefficients negated */
+		c[3] = (2.0f * cos_w0) / a0;
+		c[4] = -(1.0f - alpha) / a0;
+	}
+
+	for (int axis = 0; axis < 3; axis++) {
+		arm_biquad_cascade_df2T_init_f32(&filter->axis[axis], APP_ACCEL_FILTER_STAGES,
+						 filter->coeffs, filter->state[axis]);
+	}
+
+	filter->primed = false;
+
+	return 0;
+}
+
+static void seed_axis_state(struct app_accel_filter *filter, int axis, float32_t value)
+{
+	/* Steady-state DF2T delay values for a constant input (unity DC gain) */
+	for (int i = 0; i < APP_ACCEL_FILTER_STAGES; i++) {
+		const float32_t *c = &filter->coeffs[5 * i];
+		float32_t *d = &filter->state[axis][2 * i];
+
+		d[0] = value * (1.0f - c[0]);
+		d[1] = value * (c[2] + c[4]);
+	}
+}
+
+void app_accel_filter_process(struct app_accel_filter *filter, float32_t *x, float32_t *y,
+			      float32_t *z, size_t count)
+{
+	if (count == 0) {
+		return;
+	}
+
+	if (!filter->primed) {
+		seed_axis_state(filter, 0, x[0]);
+		seed_axis_state(filter, 1, y[0]);
+		seed_axis_state(filter, 2, z[0]);
+		filter->primed = true;
+	}
+
+	arm_biquad_cascade_df2T_f32(&filter->axis[0], x, x, count);
+	arm_biquad_cascade_df2T_f32(&filter->axis[1], y, y, count);
+	arm_biquad_cascade_df2T_f32(&filter->axis[2], z, z, count);
+}
+
+#if defined(CONFIG_APP_ACCEL_FILTER_BENCHMARK)
+#define BENCHMARK_BLOCK_SIZE CONFIG_APP_ACCEL_BLOCK_SIZE
+
+void app_accel_filter_benchmark(void)
+{
+	static float32_t x[BENCHMARK_BLOCK_SIZE];
+	static float32_t y[BENCHMARK_BLOCK_SIZE];
+	static float32_t z[BENCHMARK_BLOCK_SIZE];
+	struct app_accel_filter filter;
+	volatile float32_t sum = 0.0f;
+	timing_t start, end;
+	uint64_t filter_cycles;
+	uint64_t mean_cycles;
+
+	for (int i = 0; i < BENCHMARK_BLOCK_SIZE; i++) {
+		x[i] = 0.1f * (float32_t)(i % 7);
+		y[i] = 4.0f + 0.1f * (float32_t)(i % 5);
+		z[i] = -9.0f + 0.1f * (float32_t)(i % 3);
+	}
+
+	if (app_accel_filter_init(&filter, 10.0f, 0.2f)) {
+		return;
+	}
+
+	timing_init();
+	timing_start();
+
+	start = timing_counter_get();
+	for (int i = 0; i < BENCHMARK_BLOCK_SIZE; i++) {
+		sum += x[i];
+		sum += y[i];
+		sum += z[i];
+	}
+	end = timing_counter_get();
+	mean_cycles = timing_cycles_get(&start, &end);
+
+	start = timing_counter_get();
+	app_accel_filter_process(&filter, x, y, z, BENCHMARK_BLOCK_SIZE);
+	end = timing_counter_get();
+	filter_cycles = timing_cycles_get(&start, &end);
+
+	timing_stop();
+
+	LOG_INF("Filter benchmark: scalar mean %llu cycles/sample, biquad filter %llu "
+		"cycles/sample (%d stages, block size %d)",
+		mean_cycles / BENCHMARK_BLOCK_SIZE, filter_cycles / BENCHMARK_BLOCK_SIZE,
+		APP_ACCEL_FILTER_STAGES, BENCHMARK_BLOCK_SIZE);
+}
+#endif
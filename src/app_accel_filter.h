@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_ACCEL_FILTER_H__
+#define __APP_ACCEL_FILTER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <arm_math.h>
+
+#define APP_ACCEL_FILTER_STAGES CONFIG_APP_ACCEL_FILTER_STAGES
+
+/*
+ * Low-pass filter for the three accelerometer axes, implemented as a cascade
+ * of identical 2nd-order Butterworth biquad sections using the CMSIS-DSP
+ * transposed direct form II kernels.
+ */
+struct app_accel_filter {
+	arm_biquad_cascade_df2T_instance_f32 axis[3];
+	float32_t coeffs[5 * APP_ACCEL_FILTER_STAGES];
+	float32_t state[3][2 * APP_ACCEL_FILTER_STAGES];
+	bool primed;
+};
+
+/*
+ * Initialize the filter for the given sample rate and cutoff frequency.
+ * Returns -EINVAL if the cutoff is not below the Nyquist frequency.
+ */
+int app_accel_filter_init(struct app_accel_filter *filter, float sample_rate_hz,
+			  float cutoff_hz);
+
+/*
+ * Filter a block of samples in place. The filter state is seeded from the
+ * first sample so that the output does not ramp up from zero.
+ */
+void app_accel_filter_process(struct app_accel_filter *filter, float32_t *x, float32_t *y,
+			      float32_t *z, size_t count);
+
+#if defined(CONFIG_APP_ACCEL_FILTER_BENCHMARK)
+/* Log the cycles per sample of the filter compared to a scalar mean */
+void app_accel_filter_benchmark(void);
+#endif
+
+#endif /* __APP_ACCEL_FILTER_H__ */
@@ -0,0 +1,512 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Offline backlog of sensor readings stored in external flash.
+ *
+ * Readings are appended to a flash circular buffer (FCB), which writes each
+ * sector sequentially and erases the oldest sector when it runs out of space,
+ * so wear is spread evenly over the whole partition. Each entry is protected
+ * by a CRC, so a reading interrupted by a reset is simply skipped.
+ *
+ * The position of the next reading to send is kept in a small cursor which
+ * is saved to the settings partition after each batch is sent. On boot, the
+ * cursor is checked against the sequence number of the entry it points to, so
+ * replay can resume without walking the backlog. The cursor is only advanced
+ * after Golioth has acknowledged a batch, so a reading may be sent twice (but
+ * is never lost) if a reset happens in between.
+ */
+
+#include "app_backlog.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <golioth/client.h>
+#include <golioth/stream.h>
+#if defined(CONFIG_DATE_TIME)
+#include <date_time.h>
+#endif
+#include <zcbor_encode.h>
+#include <zephyr/device.h>
+#include <zephyr/fs/fcb.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/pm/device.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/storage/flash_map.h>
+
+#include "app_payload.h"
+
+LOG_MODULE_REGISTER(app_backlog, CONFIG_APP_LOG_LEVEL);
+
+#define BACKLOG_PARTITION_ID FIXED_PARTITION_ID(backlog_storage)
+#define BACKLOG_MAGIC	     0x424b4c47 /* "BKLG" */
+#define BACKLOG_VERSION	     1
+#define BACKLOG_NO_SECTOR    UINT16_MAX
+
+/* Bump whenever struct backlog_record or struct sensor_reading changes */
+#define BACKLOG_RECORD_VERSION 2
+
+struct backlog_record {
+	/* Layout of the record (BACKLOG_RECORD_VERSION) */
+	uint8_t version;
+	/* Sequence number, incremented for every stored reading */
+	uint32_t seq;
+	/* Unix time of the reading, or 0 if the time was unknown */
+	int64_t unix_time_ms;
+	struct sensor_reading reading;
+};
+
+struct backlog_cursor {
+	/* Next sequence number to send */
+	uint32_t seq;
+	/* Location of the last entry sent, or BACKLOG_NO_SECTOR to start at the oldest entry */
+	uint16_t sector;
+	uint32_t elem_off;
+};
+
+static struct golioth_client *s_client;
+static const struct device *const s_flash_dev = DEVICE_DT_GET(DT_ALIAS(spi_flash0));
+static struct flash_sector s_sectors[CONFIG_APP_BACKLOG_MAX_SECTORS];
+static struct fcb s_fcb;
+static bool s_ready;
+
+static uint32_t s_next_seq;
+/* Readings stored before this sequence number were taken in a previous boot */
+static uint32_t s_boot_seq;
+static struct backlog_cursor s_cursor;
+static bool s_cursor_loaded;
+
+static struct backlog_record s_records[CONFIG_APP_BACKLOG_DRAIN_BATCH_SIZE];
+static struct backlog_record s_scratch;
+static struct sensor_reading *s_drain_readings[CONFIG_APP_BACKLOG_DRAIN_BATCH_SIZE];
+static uint8_t s_cbor_buf[CONFIG_APP_BACKLOG_CBOR_BUF_SIZE];
+
+static int backlog_settings_set(const char *key, size_t len, settings_read_cb read_cb,
+				void *cb_arg)
+{
+	if (strcmp(key, "cursor") != 0) {
+		return -ENOENT;
+	}
+
+	if (len != sizeof(s_cursor)) {
+		return -EINVAL;
+	}
+
+	if (read_cb(cb_arg, &s_cursor, sizeof(s_cursor)) == sizeof(s_cursor)) {
+		s_cursor_loaded = true;
+	}
+
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app_backlog, "app/backlog", NULL, backlog_settings_set, NULL, NULL);
+
+/* The external flash is suspended by main() between connections */
+static bool flash_get(void)
+{
+#if defined(CONFIG_PM_DEVICE)
+	enum pm_device_state state;
+
+	if (pm_device_state_get(s_flash_dev, &state) == 0 && state == PM_DEVICE_STATE_SUSPENDED) {
+		pm_device_action_run(s_flash_dev, PM_DEVICE_ACTION_RESUME);
+		return true;
+	}
+#endif
+
+	return false;
+}
+
+static void flash_put(bool resumed)
+{
+#if defined(CONFIG_PM_DEVICE)
+	if (resumed) {
+		pm_device_action_run(s_flash_dev, PM_DEVICE_ACTION_SUSPEND);
+	}
+#endif
+}
+
+static int read_record(struct fcb_entry *loc, struct backlog_record *record)
+{
+	int err;
+
+	if (loc->fe_data_len != sizeof(*record)) {
+		/* Stored by firmware with a different reading layout */
+		return -EBADMSG;
+	}
+
+	err = flash_area_read(s_fcb.fap, FCB_ENTRY_FA_DATA_OFF((*loc)), record, sizeof(*record));
+	if (err) {
+		return err;
+	}
+
+	if (record->version != BACKLOG_RECORD_VERSION) {
+		/* Same size, but stored by firmware with a different layout */
+		return -EBADMSG;
+	}
+
+	return 0;
+}
+
+static void cursor_to_loc(const struct backlog_cursor *cursor, struct fcb_entry *loc)
+{
+	*loc = (struct fcb_entry){0};
+
+	if (cursor->sector != BACKLOG_NO_SECTOR) {
+		loc->fe_sector = &s_sectors[cursor->sector];
+		loc->fe_elem_off = cursor->elem_off;
+	}
+}
+
+static void cursor_reset(void)
+{
+	struct fcb_entry loc = {0};
+
+	s_cursor.sector = BACKLOG_NO_SECTOR;
+	s_cursor.elem_off = 0;
+	s_cursor.seq = s_next_seq;
+
+	/* Send everything from the oldest entry still in flash */
+	while (fcb_getnext(&s_fcb, &loc) == 0) {
+		if (read_record(&loc, &s_scratch) == 0) {
+			s_cursor.seq = s_scratch.seq;
+			break;
+		}
+	}
+}
+
+static bool cursor_is_valid(void)
+{
+	struct fcb_entry loc;
+	int err;
+
+	if (s_cursor.sector != BACKLOG_NO_SECTOR && s_cursor.sector >= s_fcb.f_sector_cnt) {
+		return false;
+	}
+
+	if (s_cursor.seq == s_next_seq) {
+		/* Everything has been sent */
+		return true;
+	}
+
+	if (s_cursor.seq > s_next_seq) {
+		return false;
+	}
+
+	/* The entry after the cursor must be the next one to send */
+	cursor_to_loc(&s_cursor, &loc);
+	err = fcb_getnext(&s_fcb, &loc);
+	if (err) {
+		return false;
+	}
+
+	return read_record(&loc, &s_scratch) == 0 && s_scratch.seq == s_cursor.seq;
+}
+
+static void find_next_seq(void)
+{
+	struct fcb_entry loc = {
+		.fe_sector = s_fcb.f_active.fe_sector,
+	};
+	bool found = false;
+
+	s_next_seq = 0;
+
+	/* Only the active sector needs to be read to find the newest entry */
+	while (fcb_getnext(&s_fcb, &loc) == 0) {
+		if (read_record(&loc, &s_scratch) == 0) {
+			s_next_seq = s_scratch.seq + 1;
+			found = true;
+		}
+	}
+
+	if (!found) {
+		/* The active sector has no readable entries, so read them all */
+		loc = (struct fcb_entry){0};
+		while (fcb_getnext(&s_fcb, &loc) == 0) {
+			if (read_record(&loc, &s_scratch) == 0) {
+				s_next_seq = s_scratch.seq + 1;
+			}
+		}
+	}
+}
+
+static void save_cursor(void)
+{
+	int err;
+
+	err = settings_save_one("app/backlog/cursor", &s_cursor, sizeof(s_cursor));
+	if (err) {
+		LOG_ERR("Failed to save backlog cursor: %d", err);
+	}
+}
+
+int app_backlog_init(struct golioth_client *client)
+{
+	uint32_t sector_cnt = ARRAY_SIZE(s_sectors);
+	bool resumed;
+	int err;
+
+	s_client = client;
+
+	if (!device_is_ready(s_flash_dev)) {
+		LOG_ERR("External flash not ready");
+		return -ENODEV;
+	}
+
+	err = flash_area_get_sectors(BACKLOG_PARTITION_ID, &sector_cnt, s_sectors);
+	if (err) {
+		LOG_ERR("Failed to get backlog flash sectors: %d", err);
+		return err;
+	}
+
+	s_fcb.f_magic = BACKLOG_MAGIC;
+	s_fcb.f_version = BACKLOG_VERSION;
+	s_fcb.f_sector_cnt = sector_cnt;
+	s_fcb.f_scratch_cnt = 0;
+	s_fcb.f_sectors = s_sectors;
+
+	resumed = flash_get();
+
+	err = fcb_init(BACKLOG_PARTITION_ID, &s_fcb);
+	if (err) {
+		LOG_ERR("Failed to initialize backlog: %d", err);
+		flash_put(resumed);
+		return err;
+	}
+
+	find_next_seq();
+	s_boot_seq = s_next_seq;
+
+	err = settings_subsys_init();
+	if (!err) {
+		err = settings_load_subtree("app/backlog");
+	}
+	if (err) {
+		LOG_ERR("Failed to load backlog cursor: %d", err);
+	}
+
+	if (!s_cursor_loaded || !cursor_is_valid()) {
+		LOG_WRN("Backlog cursor not found, replaying from the oldest reading");
+		cursor_reset();
+	}
+
+	flash_put(resumed);
+
+	s_ready = true;
+
+	LOG_INF("Backlog initialized with %u readings to send", s_next_seq - s_cursor.seq);
+
+	return 0;
+}
+
+int app_backlog_store(const struct sensor_reading *reading)
+{
+	struct backlog_record record = {0};
+	struct fcb_entry loc;
+	bool resumed;
+	int err;
+
+	if (!s_ready) {
+		return -ENODEV;
+	}
+
+	record.version = BACKLOG_RECORD_VERSION;
+	record.seq = s_next_seq;
+	record.unix_time_ms = 0;
+	record.reading = *reading;
+#if defined(CONFIG_DATE_TIME)
+	int64_t unix_time_ms;
+
+	if (date_time_now(&unix_time_ms) == 0) {
+		record.unix_time_ms = unix_time_ms - (k_uptime_get() - reading->uptime_ms);
+	}
+#endif
+
+	resumed = flash_get();
+
+	err = fcb_append(&s_fcb, sizeof(record), &loc);
+	if (err == -ENOSPC) {
+		/* Make room by erasing the oldest sector of readings */
+		err = fcb_rotate(&s_fcb);
+		if (!err) {
+			err = fcb_append(&s_fcb, sizeof(record), &loc);
+		}
+
+		if (!err && !cursor_is_valid()) {
+			LOG_WRN("Backlog is full, dropped oldest unsent readings");
+			cursor_reset();
+		}
+	}
+	if (err) {
+		LOG_ERR("Failed to allocate backlog entry: %d", err);
+		goto out;
+	}
+
+	err = flash_area_write(s_fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), &record, sizeof(record));
+	if (err) {
+		LOG_ERR("Failed to write backlog entry: %d", err);
+		goto out;
+	}
+
+	err = fcb_append_finish(&s_fcb, &loc);
+	if (err) {
+		LOG_ERR("Failed to finish backlog entry: %d", err);
+		goto out;
+	}
+
+	s_next_seq++;
+
+	LOG_INF("Stored reading in backlog (%u readings to send)", s_next_seq - s_cursor.seq);
+
+out:
+	flash_put(resumed);
+
+	return err;
+}
+
+bool app_backlog_is_empty(void)
+{
+	return !s_ready || s_cursor.seq == s_next_seq;
+}
+
+static void restore_reading_time(struct backlog_record *record)
+{
+	if (record->unix_time_ms == 0) {
+		/*
+		 * The time was unknown when the reading was stored. Its uptime is
+		 * only meaningful if it was taken since this boot, otherwise it is
+		 * sent without a timestamp.
+		 */
+		if (record->seq < s_boot_seq) {
+			record->reading.uptime_ms = APP_SENSORS_UPTIME_UNKNOWN;
+		}
+		return;
+	}
+
+#if defined(CONFIG_DATE_TIME)
+	int64_t unix_time_ms;
+
+	/* Convert the time of the reading to the current uptime base */
+	if (date_time_now(&unix_time_ms) == 0) {
+		record->reading.uptime_ms = k_uptime_get() - (unix_time_ms - record->unix_time_ms);
+	}
+#endif
+}
+
+static int stream_records(int count)
+{
+	int err;
+
+	ZCBOR_STATE_E(zse, 4, s_cbor_buf, sizeof(s_cbor_buf), 1);
+
+	app_payload_start();
+
+	for (int i = 0; i < count; i++) {
+		restore_reading_time(&s_records[i]);
+		s_drain_readings[i] = &s_records[i].reading;
+	}
+
+#if defined(CONFIG_APP_BATCH_COMPRESSION)
+	err = app_payload_encode_packed(zse, s_drain_readings, count);
+#else
+	err = app_payload_encode_list(zse, s_drain_readings, count);
+#endif
+	if (err) {
+		return -ENOMEM;
+	}
+
+	err = golioth_stream_set_sync(s_client, "sensor", GOLIOTH_CONTENT_TYPE_CBOR, s_cbor_buf,
+				      zse->payload - s_cbor_buf,
+				      CONFIG_APP_GOLIOTH_STREAM_TIMEOUT_S);
+	if (err != GOLIOTH_OK) {
+		LOG_ERR("Failed to send backlog to Golioth: %d", err);
+		return -EIO;
+	}
+
+	app_payload_sent();
+
+	return 0;
+}
+
+static int drain_batch(void)
+{
+	struct fcb_entry loc;
+	struct fcb_entry last;
+	int count = 0;
+	int err;
+
+	cursor_to_loc(&s_cursor, &loc);
+	last = loc;
+
+	while (count < ARRAY_SIZE(s_records) && fcb_getnext(&s_fcb, &loc) == 0) {
+		last = loc;
+
+		if (read_record(&loc, &s_records[count]) != 0 ||
+		    s_records[count].seq < s_cursor.seq) {
+			continue;
+		}
+
+		count++;
+	}
+
+	if (count > 0) {
+		err = stream_records(count);
+		if (err) {
+			return err;
+		}
+
+		LOG_INF("Sent %d readings from backlog", count);
+	}
+
+	s_cursor.sector = last.fe_sector ? (last.fe_sector - s_sectors) : BACKLOG_NO_SECTOR;
+	s_cursor.elem_off = last.fe_elem_off;
+	s_cursor.seq = (count > 0) ? (s_records[count - 1].seq + 1) : s_next_seq;
+	save_cursor();
+
+	/* Erase sectors which have been sent completely */
+	while (last.fe_sector && s_fcb.f_oldest != last.fe_sector) {
+		err = fcb_rotate(&s_fcb);
+		if (err) {
+			LOG_ERR("Failed to erase sent backlog sector: %d", err);
+			break;
+		}
+	}
+
+	return 0;
+}
+
+int app_backlog_drain(void)
+{
+	bool resumed;
+	int err = 0;
+
+	if (app_backlog_is_empty()) {
+		return 0;
+	}
+
+	if (!golioth_client_is_connected(s_client)) {
+		return -ENOTCONN;
+	}
+
+	resumed = flash_get();
+
+	for (int i = 0; i < CONFIG_APP_BACKLOG_DRAIN_MAX_BATCHES && !app_backlog_is_empty(); i++) {
+		err = drain_batch();
+		if (err) {
+			break;
+		}
+	}
+
+	flash_put(resumed);
+
+	if (!app_backlog_is_empty()) {
+		LOG_INF("%u readings remaining in backlog", s_next_seq - s_cursor.seq);
+	}
+
+	return err;
+}
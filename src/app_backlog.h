@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_BACKLOG_H__
+#define __APP_BACKLOG_H__
+
+#include <stdbool.h>
+
+#include <golioth/client.h>
+
+#include "app_sensors.h"
+
+int app_backlog_init(struct golioth_client *client);
+
+/*
+ * Append a reading which could not be sent to the backlog in external flash.
+ * When the backlog is full, the oldest flash sector of readings is erased.
+ */
+int app_backlog_store(const struct sensor_reading *reading);
+
+bool app_backlog_is_empty(void);
+
+/*
+ * Stream stored readings to Golioth in batches of up to
+ * CONFIG_APP_BACKLOG_DRAIN_BATCH_SIZE readings, sending at most
+ * CONFIG_APP_BACKLOG_DRAIN_MAX_BATCHES batches per call.
+ */
+int app_backlog_drain(void);
+
+#endif /* __APP_BACKLOG_H__ */
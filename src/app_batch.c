@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_batch.h"
+
+#include <errno.h>
+
+#include <golioth/client.h>
+#include <golioth/stream.h>
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_APP_BACKLOG)
+#include "app_backlog.h"
+#endif
+#include "app_payload.h"
+#include "app_profile.h"
+
+LOG_MODULE_REGISTER(app_batch, CONFIG_APP_LOG_LEVEL);
+
+#define BATCH_MAX_READINGS CONFIG_APP_BATCH_MAX_READINGS
+
+BUILD_ASSERT(CONFIG_APP_BATCH_NUM_READINGS <= CONFIG_APP_BATCH_MAX_READINGS,
+	     "Batch upload threshold exceeds the batch capacity");
+
+static struct golioth_client *s_client;
+
+/* Ring buffer of readings waiting to be uploaded */
+static struct sensor_reading s_readings[BATCH_MAX_READINGS];
+static int s_oldest;
+static int s_count;
+
+static uint8_t s_cbor_buf[CONFIG_APP_BATCH_CBOR_BUF_SIZE];
+
+void app_batch_init(struct golioth_client *client)
+{
+	s_client = client;
+}
+
+void app_batch_add(const struct sensor_reading *reading)
+{
+	if (s_count == BATCH_MAX_READINGS) {
+#if defined(CONFIG_APP_BACKLOG)
+		LOG_WRN("Batch is full, moving oldest reading to backlog");
+		app_backlog_store(&s_readings[s_oldest]);
+#else
+		LOG_WRN("Batch is full, dropping oldest reading");
+#endif
+		s_oldest = (s_oldest + 1) % BATCH_MAX_READINGS;
+		s_count--;
+	}
+
+	s_readings[(s_oldest + s_count) % BATCH_MAX_READINGS] = *reading;
+	s_count++;
+
+	LOG_INF("Stored reading %d of %d in batch", s_count, CONFIG_APP_BATCH_NUM_READINGS);
+}
+
+bool app_batch_is_empty(void)
+{
+	return s_count == 0;
+}
+
+bool app_batch_upload_due(void)
+{
+	int64_t oldest_age_ms;
+
+	if (s_count == 0) {
+		return false;
+	}
+
+	if (s_count >= CONFIG_APP_BATCH_NUM_READINGS) {
+		return true;
+	}
+
+	oldest_age_ms = k_uptime_get() - s_readings[s_oldest].uptime_ms;
+
+	return oldest_age_ms >= ((int64_t)CONFIG_APP_BATCH_MAX_AGE_S * MSEC_PER_SEC);
+}
+
+static struct sensor_reading *s_batch_readings[BATCH_MAX_READINGS];
+
+static int encode_batch(int count, size_t *size)
+{
+	int err;
+
+	ZCBOR_STATE_E(zse, 4, s_cbor_buf, sizeof(s_cbor_buf), 1);
+
+	for (int i = 0; i < count; i++) {
+		s_batch_readings[i] = &s_readings[(s_oldest + i) % BATCH_MAX_READINGS];
+	}
+
+	app_payload_start();
+
+#if defined(CONFIG_APP_BATCH_COMPRESSION)
+	err = app_payload_encode_packed(zse, s_batch_readings, count);
+#else
+	err = app_payload_encode_list(zse, s_batch_readings, count);
+#endif
+	if (err) {
+		return -ENOMEM;
+	}
+
+	*size = zse->payload - s_cbor_buf;
+
+	return 0;
+}
+
+int app_batch_stream(void)
+{
+	int err;
+
+	if (!golioth_client_is_connected(s_client)) {
+		LOG_WRN("No connection available, keeping %d readings in batch", s_count);
+		return -ENOTCONN;
+	}
+
+	while (s_count > 0) {
+		int count = s_count;
+		int64_t phase_start = app_profile_start();
+		size_t size;
+
+		/* Send as many readings as fit in the CBOR buffer */
+		while ((err = encode_batch(count, &size)) == -ENOMEM && count > 1) {
+			count /= 2;
+		}
+		app_profile_end(APP_PROFILE_ENCODE, phase_start);
+		if (err) {
+			LOG_ERR("Unable to encode batch: %d", err);
+			return err;
+		}
+
+		phase_start = app_profile_start();
+		err = golioth_stream_set_sync(s_client, "sensor", GOLIOTH_CONTENT_TYPE_CBOR,
+					      s_cbor_buf, size,
+					      CONFIG_APP_GOLIOTH_STREAM_TIMEOUT_S);
+		app_profile_end(APP_PROFILE_STREAM, phase_start);
+		if (err != GOLIOTH_OK) {
+			LOG_ERR("Failed to send batch to Golioth: %d", err);
+			return -EIO;
+		}
+
+		LOG_INF("Sent batch of %d readings (%zu bytes) to Golioth", count, size);
+
+		app_profile_add_tx_bytes(size);
+
+		app_payload_sent();
+
+		s_oldest = (s_oldest + count) % BATCH_MAX_READINGS;
+		s_count -= count;
+	}
+
+	return 0;
+}
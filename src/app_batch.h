@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_BATCH_H__
+#define __APP_BATCH_H__
+
+#include <stdbool.h>
+
+#include <golioth/client.h>
+
+#include "app_sensors.h"
+
+void app_batch_init(struct golioth_client *client);
+
+/* Store a reading in the batch, replacing the oldest reading if it is full */
+void app_batch_add(const struct sensor_reading *reading);
+
+bool app_batch_is_empty(void);
+
+/*
+ * Returns true if CONFIG_APP_BATCH_NUM_READINGS readings have been stored, or
+ * the oldest stored reading is at least CONFIG_APP_BATCH_MAX_AGE_S old.
+ */
+bool app_batch_upload_due(void);
+
+/*
+ * Stream all stored readings to Golioth as CBOR arrays of timestamped
+ * readings. Readings are only removed from the batch once they have been
+ * sent successfully.
+ */
+int app_batch_stream(void);
+
+#endif /* __APP_BATCH_H__ */
@@ -32,13 +32,19 @@ static const struct device *charger = DEVICE_DT_GET(DT_NODELABEL(npm1300_charger
 static volatile bool vbus_connected;
 static int64_t ref_time;
 
+/* The charger is also read in the background by the energy accounting */
+K_MUTEX_DEFINE(charger_lock);
+
 static int charger_read_sensors(float *voltage, float *current, float *temp, int32_t *chg_status)
 {
 	struct sensor_value value;
 	int err;
 
+	k_mutex_lock(&charger_lock, K_FOREVER);
+
 	err = sensor_sample_fetch(charger);
 	if (err < 0) {
+		k_mutex_unlock(&charger_lock);
 		LOG_ERR("Could not fetch sensor data from charger");
 		return err;
 	}
@@ -55,9 +61,29 @@ static int charger_read_sensors(float *voltage, float *current, float *temp, int
 	sensor_channel_get(charger, SENSOR_CHAN_NPM1300_CHARGER_STATUS, &value);
 	*chg_status = value.val1;
 
+	k_mutex_unlock(&charger_lock);
+
 	return 0;
 }
 
+int app_battery_read_current(float *current)
+{
+	struct sensor_value value;
+	int err;
+
+	k_mutex_lock(&charger_lock, K_FOREVER);
+
+	err = sensor_sample_fetch(charger);
+	if (err == 0) {
+		sensor_channel_get(charger, SENSOR_CHAN_GAUGE_AVG_CURRENT, &value);
+		*current = sensor_value_to_float(&value);
+	}
+
+	k_mutex_unlock(&charger_lock);
+
+	return err;
+}
+
 static int charge_status_update(int32_t chg_status)
 {
 	union nrf_fuel_gauge_ext_state_info_data state_info;
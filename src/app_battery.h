@@ -7,16 +7,20 @@
 #ifndef __APP_BATTERY_H__
 #define __APP_BATTERY_H__
 
+#include "app_math.h"
+
 struct battery_status {
-	double voltage_v;
-	double current_a;
-	double temp_c;
-	double soc_pct;
-	double tte_s;
-	double ttf_s;
+	app_real_t voltage_v;
+	app_real_t current_a;
+	app_real_t temp_c;
+	app_real_t soc_pct;
+	app_real_t tte_s;
+	app_real_t ttf_s;
 };
 
 int app_battery_init(void);
 int fuel_gauge_sample(struct battery_status *status);
+/* Read the battery current (in A) without updating the fuel gauge */
+int app_battery_read_current(float *current);
 
 #endif /* __APP_BATTERY_H__ */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_codec.h"
+
+#include <errno.h>
+#include <stdbool.h>
+
+struct codec_writer {
+	uint8_t *buf;
+	size_t size;
+	size_t len;
+};
+
+struct codec_reader {
+	const uint8_t *buf;
+	size_t len;
+	size_t pos;
+};
+
+static inline uint64_t zigzag_encode(int64_t value)
+{
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t value)
+{
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static bool put_varint(struct codec_writer *writer, int64_t value)
+{
+	uint64_t zz = zigzag_encode(value);
+
+	do {
+		if (writer->len == writer->size) {
+			return false;
+		}
+
+		writer->buf[writer->len++] = (zz & 0x7f) | ((zz > 0x7f) ? 0x80 : 0);
+		zz >>= 7;
+	} while (zz != 0);
+
+	return true;
+}
+
+static bool get_varint(struct codec_reader *reader, int64_t *value)
+{
+	uint64_t zz = 0;
+
+	for (int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte;
+
+		if (reader->pos == reader->len) {
+			return false;
+		}
+
+		byte = reader->buf[reader->pos++];
+		zz |= (uint64_t)(byte & 0x7f) << shift;
+
+		if ((byte & 0x80) == 0) {
+			*value = zigzag_decode(zz);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int app_codec_encode(app_codec_get_t get, void *ctx, int count, int num_fields, uint8_t *buf,
+		     size_t size, size_t *len)
+{
+	struct codec_writer writer = {
+		.buf = buf,
+		.size = size,
+	};
+
+	for (int field = 0; field < num_fields; field++) {
+		int64_t prev = 0;
+		int64_t prev_delta = 0;
+
+		for (int i = 0; i < count; i++) {
+			int64_t value = get(ctx, i, field);
+			int64_t delta = value - prev;
+			int64_t out = delta;
+
+			if (field == 0 && i > 1) {
+				out = delta - prev_delta;
+			}
+
+			if (!put_varint(&writer, out)) {
+				return -ENOMEM;
+			}
+
+			prev = value;
+			prev_delta = delta;
+		}
+	}
+
+	*len = writer.len;
+
+	return 0;
+}
+
+int app_codec_decode(const uint8_t *buf, size_t len, int count, int num_fields, int64_t *values)
+{
+	struct codec_reader reader = {
+		.buf = buf,
+		.len = len,
+	};
+
+	for (int field = 0; field < num_fields; field++) {
+		int64_t prev = 0;
+		int64_t prev_delta = 0;
+
+		for (int i = 0; i < count; i++) {
+			int64_t delta;
+
+			if (!get_varint(&reader, &delta)) {
+				return -EBADMSG;
+			}
+
+			if (field == 0 && i > 1) {
+				delta += prev_delta;
+			}
+
+			prev += delta;
+			prev_delta = delta;
+			values[i * num_fields + field] = prev;
+		}
+	}
+
+	return (reader.pos == reader.len) ? 0 : -EBADMSG;
+}
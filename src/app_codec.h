@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_CODEC_H__
+#define __APP_CODEC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Delta compression for batches of time-series samples.
+ *
+ * Each sample is a row of integer fields, and the batch is encoded column by
+ * column. The first field is a timestamp, which is encoded as the delta of
+ * the deltas between consecutive samples. All other fields are encoded as the
+ * delta from the previous sample. The first value of each column is encoded
+ * as-is. Each value is zigzag encoded and written as an unsigned LEB128
+ * varint, so values that change slowly take a single byte per sample.
+ */
+
+/* Returns field of sample index */
+typedef int64_t (*app_codec_get_t)(void *ctx, int index, int field);
+
+/*
+ * Encode count samples of num_fields fields into buf. Returns -ENOMEM if the
+ * encoded samples do not fit.
+ */
+int app_codec_encode(app_codec_get_t get, void *ctx, int count, int num_fields, uint8_t *buf,
+		     size_t size, size_t *len);
+
+/*
+ * Reference decoder. Decodes count samples of num_fields fields into values,
+ * in sample order (values[index * num_fields + field]). Returns -EBADMSG if
+ * the data is truncated or malformed.
+ */
+int app_codec_decode(const uint8_t *buf, size_t len, int count, int num_fields, int64_t *values);
+
+#endif /* __APP_CODEC_H__ */
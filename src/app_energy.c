@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_energy.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <golioth/client.h>
+#include <golioth/stream.h>
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+#include "app_battery.h"
+
+LOG_MODULE_REGISTER(app_energy, CONFIG_APP_LOG_LEVEL);
+
+#define MS_PER_HOUR (3600LL * MSEC_PER_SEC)
+#define MS_PER_DAY  (24LL * MS_PER_HOUR)
+
+struct energy_phase {
+	int64_t time_ms;
+	/* Charge drawn from the battery (uA * ms) */
+	int64_t charge_ua_ms;
+};
+
+static const char *const s_phase_names[APP_ENERGY_NUM_PHASES] = {
+	[APP_ENERGY_SLEEP] = "sleep",
+	[APP_ENERGY_SAMPLING] = "sampling",
+	[APP_ENERGY_CONNECT] = "connect",
+	[APP_ENERGY_UPLOAD] = "upload",
+	[APP_ENERGY_TAIL] = "tail",
+};
+
+static struct energy_phase s_phases[APP_ENERGY_NUM_PHASES];
+static enum app_energy_phase s_phase = APP_ENERGY_SLEEP;
+static struct k_spinlock s_lock;
+/* Last battery current sample (discharge, in uA) */
+static int32_t s_current_ua;
+/* Uptime the charge was last integrated, and the start of the reporting window */
+static int64_t s_integrated_ms;
+static int64_t s_window_start_ms;
+static bool s_rrc_connected;
+static int s_calls_since_report;
+
+static uint8_t s_cbor_buf[CONFIG_APP_ENERGY_CBOR_BUF_SIZE];
+
+/* Read the battery discharge current (in uA) */
+static int read_current_ua(int32_t *current_ua)
+{
+	float current;
+	int err;
+
+	err = app_battery_read_current(&current);
+	if (err) {
+		return err;
+	}
+
+	/* Charging current (while on USB power) is not counted */
+	*current_ua = MAX((int32_t)(current * 1000000.0f), 0);
+
+	return 0;
+}
+
+/*
+ * Attribute the charge drawn since the last call to the current phase, with
+ * the current changing linearly from the last sample to current_ua (lock held)
+ */
+static void integrate(int64_t now_ms, int32_t current_ua)
+{
+	int64_t elapsed_ms = now_ms - s_integrated_ms;
+
+	s_phases[s_phase].time_ms += elapsed_ms;
+	s_phases[s_phase].charge_ua_ms += ((int64_t)s_current_ua + current_ua) * elapsed_ms / 2;
+	s_current_ua = current_ua;
+	s_integrated_ms = now_ms;
+}
+
+static void sample_work_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(s_sample_work, sample_work_handler);
+
+static void sample_work_handler(struct k_work *work)
+{
+	k_spinlock_key_t key;
+	int32_t current_ua;
+
+	if (read_current_ua(&current_ua) == 0) {
+		key = k_spin_lock(&s_lock);
+		integrate(k_uptime_get(), current_ua);
+		k_spin_unlock(&s_lock, key);
+	}
+
+	/*
+	 * Waking up to sample would add to the sleep current, so the current
+	 * is only sampled on entering and leaving sleep (see
+	 * app_energy_set_phase()).
+	 */
+	if (s_phase != APP_ENERGY_SLEEP) {
+		k_work_reschedule(&s_sample_work, K_MSEC(CONFIG_APP_ENERGY_SAMPLE_INTERVAL_MS));
+	}
+}
+
+void app_energy_init(void)
+{
+	s_integrated_ms = k_uptime_get();
+	s_window_start_ms = s_integrated_ms;
+
+	k_work_reschedule(&s_sample_work, K_NO_WAIT);
+}
+
+void app_energy_set_phase(enum app_energy_phase phase)
+{
+	k_spinlock_key_t key;
+	int32_t current_ua = -1;
+	bool changed;
+
+	/* Sample on waking up, so the sleep charge is integrated up to the end of the sleep */
+	if (s_phase == APP_ENERGY_SLEEP && phase != APP_ENERGY_SLEEP) {
+		(void)read_current_ua(&current_ua);
+	}
+
+	key = k_spin_lock(&s_lock);
+	changed = (phase != s_phase);
+	integrate(k_uptime_get(), (current_ua >= 0) ? current_ua : s_current_ua);
+	s_phase = phase;
+
+	k_spin_unlock(&s_lock, key);
+
+	if (current_ua >= 0) {
+		/* Sampled just now: resume sampling in the background */
+		k_work_reschedule(&s_sample_work, K_MSEC(CONFIG_APP_ENERGY_SAMPLE_INTERVAL_MS));
+	} else if (changed) {
+		/* The current usually steps at a phase change, so sample it right away */
+		k_work_reschedule(&s_sample_work, K_NO_WAIT);
+	}
+}
+
+void app_energy_cycle_end(void)
+{
+	app_energy_set_phase(s_rrc_connected ? APP_ENERGY_TAIL : APP_ENERGY_SLEEP);
+}
+
+void app_energy_lte_event(const struct lte_lc_evt *const evt)
+{
+	if (evt->type != LTE_LC_EVT_RRC_UPDATE) {
+		return;
+	}
+
+	s_rrc_connected = (evt->rrc_mode == LTE_LC_RRC_MODE_CONNECTED);
+	if (!s_rrc_connected && s_phase == APP_ENERGY_TAIL) {
+		app_energy_set_phase(APP_ENERGY_SLEEP);
+	}
+}
+
+static int encode_energy(const struct energy_phase *phases, int64_t window_ms, size_t *size)
+{
+	bool ok;
+
+	ZCBOR_STATE_E(zse, 3, s_cbor_buf, sizeof(s_cbor_buf), 1);
+
+	ok = zcbor_map_start_encode(zse, 3) && zcbor_tstr_put_lit(zse, "v") &&
+	     zcbor_uint32_put(zse, 1) && zcbor_tstr_put_lit(zse, "window") &&
+	     zcbor_int64_put(zse, window_ms / MSEC_PER_SEC) &&
+	     zcbor_tstr_put_lit(zse, "phases") &&
+	     zcbor_map_start_encode(zse, APP_ENERGY_NUM_PHASES);
+	for (int i = 0; ok && i < APP_ENERGY_NUM_PHASES; i++) {
+		float charge_mah = (float)phases[i].charge_ua_ms / (MS_PER_HOUR * 1000);
+		float mah_per_day = charge_mah * (float)MS_PER_DAY / (float)window_ms;
+
+		ok = zcbor_tstr_put_term(zse, s_phase_names[i], SIZE_MAX) &&
+		     zcbor_list_start_encode(zse, 3) &&
+		     zcbor_int64_put(zse, phases[i].time_ms / MSEC_PER_SEC) &&
+		     zcbor_float32_put(zse, charge_mah) && zcbor_float32_put(zse, mah_per_day) &&
+		     zcbor_list_end_encode(zse, 3);
+
+		LOG_INF("%s: %lld s, %.3f mAh (%.3f mAh/day)", s_phase_names[i],
+			phases[i].time_ms / MSEC_PER_SEC, (double)charge_mah, (double)mah_per_day);
+	}
+	ok = ok && zcbor_map_end_encode(zse, APP_ENERGY_NUM_PHASES) &&
+	     zcbor_map_end_encode(zse, 3);
+	if (!ok) {
+		LOG_ERR("Failed to encode energy report: %d", zcbor_peek_error(zse));
+		return -ENOMEM;
+	}
+
+	*size = zse->payload - s_cbor_buf;
+
+	return 0;
+}
+
+int app_energy_stream(struct golioth_client *client)
+{
+	struct energy_phase phases[APP_ENERGY_NUM_PHASES];
+	k_spinlock_key_t key;
+	int64_t now_ms;
+	size_t size;
+	int err;
+
+	if (++s_calls_since_report < CONFIG_APP_ENERGY_REPORT_INTERVAL) {
+		return 0;
+	}
+
+	key = k_spin_lock(&s_lock);
+	now_ms = k_uptime_get();
+	integrate(now_ms, s_current_ua);
+	memcpy(phases, s_phases, sizeof(phases));
+	k_spin_unlock(&s_lock, key);
+
+	if (now_ms <= s_window_start_ms) {
+		return 0;
+	}
+
+	err = encode_energy(phases, now_ms - s_window_start_ms, &size);
+	if (err) {
+		return err;
+	}
+
+	err = golioth_stream_set_sync(client, "energy", GOLIOTH_CONTENT_TYPE_CBOR, s_cbor_buf,
+				      size, CONFIG_APP_GOLIOTH_STREAM_TIMEOUT_S);
+	if (err != GOLIOTH_OK) {
+		LOG_ERR("Failed to send energy report to Golioth: %d", err);
+		return -EIO;
+	}
+
+	LOG_INF("Sent energy report to Golioth");
+
+	/* Start a new window, keeping the charge drawn while the report was sent */
+	key = k_spin_lock(&s_lock);
+	for (int i = 0; i < APP_ENERGY_NUM_PHASES; i++) {
+		s_phases[i].time_ms -= phases[i].time_ms;
+		s_phases[i].charge_ua_ms -= phases[i].charge_ua_ms;
+	}
+	k_spin_unlock(&s_lock, key);
+
+	s_window_start_ms = now_ms;
+	s_calls_since_report = 0;
+
+	return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_ENERGY_H__
+#define __APP_ENERGY_H__
+
+#include <golioth/client.h>
+#include <modem/lte_lc.h>
+
+/* Wake cycle phases, in the order they are reported (see schema/diagnostics.cddl) */
+enum app_energy_phase {
+	/* Sleeping between cycles (including any TAU the modem performs) */
+	APP_ENERGY_SLEEP,
+	/* Taking a reading before connecting */
+	APP_ENERGY_SAMPLING,
+	/* LTE wake up and DTLS handshake */
+	APP_ENERGY_CONNECT,
+	/* Connected to Golioth: settings, readings and OTA */
+	APP_ENERGY_UPLOAD,
+	/* After the cycle, until the network releases the RRC connection */
+	APP_ENERGY_TAIL,
+	APP_ENERGY_NUM_PHASES,
+};
+
+/* Start sampling the battery current in the background */
+void app_energy_init(void);
+
+/* Attribute the charge drawn from now on to a phase */
+void app_energy_set_phase(enum app_energy_phase phase);
+
+/* End the cycle: the idle tail lasts until the RRC connection is released */
+void app_energy_cycle_end(void);
+
+/* Track the RRC connection state, to detect the end of the idle tail */
+void app_energy_lte_event(const struct lte_lc_evt *const evt);
+
+/*
+ * Stream the charge drawn in each phase to the Golioth "energy" path every
+ * CONFIG_APP_ENERGY_REPORT_INTERVAL calls, and reset it once sent.
+ */
+int app_energy_stream(struct golioth_client *client);
+
+#endif /* __APP_ENERGY_H__ */
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_fast_math.h"
+
+#include <errno.h>
+#include <math.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define PI_F   ((float)M_PI)
+#define PI_2_F ((float)(M_PI / 2.0))
+
+/* atan(z) for z in [0, 1] */
+static inline float fast_atanf_unit(float z)
+{
+	float z2 = z * z;
+
+	return z * (0.99997726f +
+		    z2 * (-0.33262347f +
+			  z2 * (0.19354346f +
+				z2 * (-0.11643287f + z2 * (0.05265332f + z2 * -0.01172120f)))));
+}
+
+float app_fast_atan2f(float y, float x)
+{
+	float abs_x = fabsf(x);
+	float abs_y = fabsf(y);
+	float angle;
+
+	if (abs_x == 0.0f && abs_y == 0.0f) {
+		return 0.0f;
+	}
+
+	/* Reduce to the first octant so the polynomial argument is in [0, 1] */
+	if (abs_y <= abs_x) {
+		angle = fast_atanf_unit(abs_y / abs_x);
+	} else {
+		angle = PI_2_F - fast_atanf_unit(abs_x / abs_y);
+	}
+
+	if (x < 0.0f) {
+		angle = PI_F - angle;
+	}
+
+	return (y < 0.0f) ? -angle : angle;
+}
+
+float app_fast_sinf(float x)
+{
+	float x2;
+
+	/* Reflect into [-π/2, π/2] using sin(x) = sin(π - x) */
+	if (x > PI_2_F) {
+		x = PI_F - x;
+	} else if (x < -PI_2_F) {
+		x = -PI_F - x;
+	}
+
+	x2 = x * x;
+
+	return x * (1.0f +
+		    x2 * (-0.16666667f +
+			  x2 * (0.0083333310f + x2 * (-0.00019840874f + x2 * 2.7525562e-6f))));
+}
+
+#if defined(CONFIG_APP_HEIGHT_TABLE)
+
+#define HEIGHT_TABLE_SIZE CONFIG_APP_HEIGHT_TABLE_SIZE
+#define HEIGHT_TABLE_STEP (PI_F / (HEIGHT_TABLE_SIZE - 1))
+
+BUILD_ASSERT(HEIGHT_TABLE_SIZE >= 2, "Height table needs at least two entries");
+
+struct height_table {
+	/* Settings the table was built for */
+	float float_length_in;
+	float float_offset_in;
+	float height_in[HEIGHT_TABLE_SIZE];
+};
+
+/*
+ * Two copies of the table are kept so that a settings update (Golioth client
+ * thread) can rebuild one while the sensor path (system thread) reads the
+ * other. The generation selects the current copy, and readers retry if it
+ * changed while they were reading, since the next rebuild overwrites the copy
+ * they were using.
+ */
+static struct height_table s_height_tables[2];
+static atomic_t s_height_table_generation;
+static K_MUTEX_DEFINE(s_height_table_lock);
+
+void app_height_table_build(float float_length_in, float float_offset_in)
+{
+	struct height_table *table;
+
+	k_mutex_lock(&s_height_table_lock, K_FOREVER);
+
+	table = &s_height_tables[(atomic_get(&s_height_table_generation) + 1) & 1];
+	table->float_length_in = float_length_in;
+	table->float_offset_in = float_offset_in;
+	for (int i = 0; i < HEIGHT_TABLE_SIZE; i++) {
+		float pitch_rad = -PI_2_F + (float)i * HEIGHT_TABLE_STEP;
+
+		table->height_in[i] = float_length_in * sinf(pitch_rad) + float_offset_in;
+	}
+
+	barrier_dmem_fence_full();
+	atomic_inc(&s_height_table_generation);
+
+	k_mutex_unlock(&s_height_table_lock);
+}
+
+static float interpolate_height(const float *height_in, float pitch_rad)
+{
+	float pos = (pitch_rad + PI_2_F) / HEIGHT_TABLE_STEP;
+	int index;
+
+	if (pos <= 0.0f) {
+		return height_in[0];
+	}
+
+	if (pos >= (float)(HEIGHT_TABLE_SIZE - 1)) {
+		return height_in[HEIGHT_TABLE_SIZE - 1];
+	}
+
+	index = (int)pos;
+
+	return height_in[index] + (pos - (float)index) * (height_in[index + 1] - height_in[index]);
+}
+
+int app_height_table_lookup(float float_length_in, float float_offset_in, float pitch_rad,
+			    float *float_height_in)
+{
+	const struct height_table *table;
+	atomic_val_t generation;
+	float height_in = 0.0f;
+	bool built_for_settings;
+
+	do {
+		generation = atomic_get(&s_height_table_generation);
+		barrier_dmem_fence_full();
+		table = &s_height_tables[generation & 1];
+		built_for_settings = (table->float_length_in == float_length_in) &&
+				     (table->float_offset_in == float_offset_in);
+		if (built_for_settings) {
+			height_in = interpolate_height(table->height_in, pitch_rad);
+		}
+		barrier_dmem_fence_full();
+	} while (atomic_get(&s_height_table_generation) != generation);
+
+	if (!built_for_settings) {
+		return -ESTALE;
+	}
+
+	*float_height_in = height_in;
+
+	return 0;
+}
+
+#endif /* CONFIG_APP_HEIGHT_TABLE */
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_FAST_MATH_H__
+#define __APP_FAST_MATH_H__
+
+/*
+ * Minimax polynomial approximation of atan2f().
+ *
+ * Maximum absolute error is 2e-6 rad over the full range of inputs.
+ */
+float app_fast_atan2f(float y, float x);
+
+/*
+ * Minimax polynomial approximation of sinf() for x in [-π, π].
+ *
+ * Maximum absolute error is 4e-6 over the supported input range.
+ */
+float app_fast_sinf(float x);
+
+/*
+ * Rebuild the pitch → float height interpolation table for the given float
+ * arm length and offset. Readers keep using the previous table until the new
+ * one is complete.
+ */
+void app_height_table_build(float float_length_in, float float_offset_in);
+
+/*
+ * Look up the float height for the given pitch angle in [-π/2, π/2] using
+ * linear interpolation. Pitch values outside this range are clamped.
+ *
+ * Maximum absolute error is FLOAT_LENGTH * (π / (N - 1))² / 8, where N is
+ * CONFIG_APP_HEIGHT_TABLE_SIZE (0.0019 in for a 100 in float arm and the
+ * default table size).
+ *
+ * Returns -ESTALE if the table was not built for the given float arm length
+ * and offset (e.g. while it is rebuilt after a settings update).
+ */
+int app_height_table_lookup(float float_length_in, float float_offset_in, float pitch_rad,
+			    float *float_height_in);
+
+#endif /* __APP_FAST_MATH_H__ */
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_lte_window.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "app_schedule.h"
+
+LOG_MODULE_REGISTER(app_lte_window, CONFIG_APP_LOG_LEVEL);
+
+static struct k_spinlock s_lock;
+
+/* Negotiated PSM parameters (-1 if unknown) */
+static int s_tau_s = -1;
+static int s_active_time_s = -1;
+
+static bool s_rrc_connected;
+static bool s_modem_asleep;
+/* Uptime of the last RRC release, and of the expected next TAU (-1 if unknown) */
+static int64_t s_rrc_idle_ms = -1;
+static int64_t s_next_tau_ms = -1;
+
+void app_lte_window_event(const struct lte_lc_evt *const evt)
+{
+	k_spinlock_key_t key = k_spin_lock(&s_lock);
+	int64_t now_ms = k_uptime_get();
+	bool flush = false;
+
+	switch (evt->type) {
+	case LTE_LC_EVT_RRC_UPDATE:
+		s_rrc_connected = (evt->rrc_mode == LTE_LC_RRC_MODE_CONNECTED);
+		if (!s_rrc_connected) {
+			/* The periodic TAU timer (T3412) restarts when RRC is released */
+			s_rrc_idle_ms = now_ms;
+			if (s_tau_s > 0) {
+				s_next_tau_ms = now_ms + (int64_t)s_tau_s * MSEC_PER_SEC;
+			}
+		}
+		break;
+	case LTE_LC_EVT_PSM_UPDATE:
+		s_tau_s = evt->psm_cfg.tau;
+		s_active_time_s = evt->psm_cfg.active_time;
+		break;
+	case LTE_LC_EVT_TAU_PRE_WARNING:
+		flush = true;
+		break;
+	case LTE_LC_EVT_MODEM_SLEEP_EXIT:
+		s_modem_asleep = false;
+		break;
+	case LTE_LC_EVT_MODEM_SLEEP_ENTER:
+		if (evt->modem_sleep.type == LTE_LC_MODEM_SLEEP_PSM ||
+		    evt->modem_sleep.type == LTE_LC_MODEM_SLEEP_PROPRIETARY_PSM) {
+			s_modem_asleep = true;
+			/* The modem wakes up for the TAU at the end of the PSM sleep */
+			if (evt->modem_sleep.time > 0) {
+				s_next_tau_ms = now_ms + evt->modem_sleep.time;
+			}
+		}
+		break;
+	default:
+		break;
+	}
+
+	k_spin_unlock(&s_lock, key);
+
+	if (flush) {
+		LOG_INF("Tracking Area Update in %lld ms, uploading pending readings", evt->time);
+		app_schedule_trigger(APP_SCHEDULE_FLUSH);
+	}
+}
+
+bool app_lte_window_modem_awake(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&s_lock);
+	bool awake = s_rrc_connected;
+
+	if (!awake && !s_modem_asleep && s_rrc_idle_ms >= 0 && s_active_time_s > 0) {
+		awake = (k_uptime_get() - s_rrc_idle_ms) <
+			((int64_t)s_active_time_s * MSEC_PER_SEC);
+	}
+
+	k_spin_unlock(&s_lock, key);
+
+	return awake;
+}
+
+bool app_lte_window_tau_soon(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&s_lock);
+	int64_t time_to_tau_ms = s_next_tau_ms - k_uptime_get();
+	bool soon = s_next_tau_ms >= 0 && time_to_tau_ms > 0 &&
+		    time_to_tau_ms <= ((int64_t)CONFIG_APP_LTE_WINDOW_TAU_DEFER_S * MSEC_PER_SEC);
+
+	k_spin_unlock(&s_lock, key);
+
+	return soon;
+}
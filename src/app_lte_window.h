@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_LTE_WINDOW_H__
+#define __APP_LTE_WINDOW_H__
+
+#include <stdbool.h>
+
+#include <modem/lte_lc.h>
+
+/*
+ * Track the RRC, PSM, modem sleep and TAU pre-warning events. A TAU pre-warning
+ * triggers the APP_SCHEDULE_FLUSH job, so pending readings are uploaded in the
+ * same radio session as the Tracking Area Update.
+ */
+void app_lte_window_event(const struct lte_lc_evt *const evt);
+
+/* Returns true if the modem is connected, or still in the PSM active time */
+bool app_lte_window_modem_awake(void);
+
+/*
+ * Returns true if the modem will wake up for a Tracking Area Update within
+ * CONFIG_APP_LTE_WINDOW_TAU_DEFER_S, so an upload can wait for it.
+ */
+bool app_lte_window_tau_soon(void);
+
+#endif /* __APP_LTE_WINDOW_H__ */
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_MATH_H__
+#define __APP_MATH_H__
+
+#include <math.h>
+
+/*
+ * Scalar type used for the sensor math pipeline.
+ *
+ * The Cortex-M33 FPU on the nRF9151 only supports single precision, so double
+ * precision math is emulated in software. CONFIG_APP_MATH_SINGLE_PRECISION
+ * switches the whole pipeline (accumulation, trig, unit conversion, and CBOR
+ * encoding) to float so it runs on the FPU.
+ */
+#if defined(CONFIG_APP_MATH_SINGLE_PRECISION)
+typedef float app_real_t;
+
+#define APP_REAL(x) ((float)(x))
+
+#define app_fabs  fabsf
+#define app_sqrt  sqrtf
+#define app_ldexp ldexpf
+
+#if defined(CONFIG_APP_FAST_MATH)
+#include "app_fast_math.h"
+
+#define app_atan2 app_fast_atan2f
+#define app_sin	  app_fast_sinf
+#else
+#define app_atan2 atan2f
+#define app_sin	  sinf
+#endif
+
+#define app_real_put		 zcbor_float32_put
+#define sensor_value_to_app_real sensor_value_to_float
+#else
+typedef double app_real_t;
+
+#define APP_REAL(x) ((double)(x))
+
+#define app_fabs  fabs
+#define app_sqrt  sqrt
+#define app_atan2 atan2
+#define app_sin	  sin
+#define app_ldexp ldexp
+
+#define app_real_put		 zcbor_float64_put
+#define sensor_value_to_app_real sensor_value_to_double
+#endif
+
+#endif /* __APP_MATH_H__ */
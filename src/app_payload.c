@@ -0,0 +1,673 @@
+/*
+ * Copyright (c) 2022-2023 Golioth, Inc.
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_payload.h"
+
+#include <errno.h>
+#include <math.h>
+
+#if defined(CONFIG_DATE_TIME)
+#include <date_time.h>
+#endif
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_APP_BATCH_COMPRESSION)
+#include "app_codec.h"
+#endif
+#if defined(CONFIG_APP_PAYLOAD_SELF_CHECK)
+#include "sensor_payload_decode.h"
+#endif
+
+LOG_MODULE_REGISTER(app_payload, CONFIG_APP_LOG_LEVEL);
+
+/* picolibc does not define M_PI for Zephyr, see app_sensors.c */
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static inline app_real_t rad_to_deg(app_real_t rad)
+{
+	return rad * APP_REAL(180.0 / M_PI);
+}
+
+static int encode_accel_data(zcbor_state_t *zse, struct accel_xyz *accel_data,
+			     struct accel_summary *accel_summary)
+{
+	bool ok;
+
+	ok = zcbor_tstr_put_lit(zse, "accel") && zcbor_map_start_encode(zse, 6);
+	if (!ok) {
+		LOG_ERR("ZCBOR unable to open accel map");
+		return -1;
+	}
+
+	ok = zcbor_tstr_put_lit(zse, "x") && app_real_put(zse, accel_data->x) &&
+	     zcbor_tstr_put_lit(zse, "y") && app_real_put(zse, accel_data->y) &&
+	     zcbor_tstr_put_lit(zse, "z") && app_real_put(zse, accel_data->z);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode accel data");
+		return -1;
+	}
+
+	ok = zcbor_tstr_put_lit(zse, "var") && zcbor_map_start_encode(zse, 3) &&
+	     zcbor_tstr_put_lit(zse, "x") && app_real_put(zse, accel_summary->variance.x) &&
+	     zcbor_tstr_put_lit(zse, "y") && app_real_put(zse, accel_summary->variance.y) &&
+	     zcbor_tstr_put_lit(zse, "z") && app_real_put(zse, accel_summary->variance.z) &&
+	     zcbor_map_end_encode(zse, 3);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode accel variance");
+		return -1;
+	}
+
+	ok = zcbor_tstr_put_lit(zse, "n") && zcbor_int32_put(zse, accel_summary->num_samples) &&
+	     zcbor_tstr_put_lit(zse, "rejected") &&
+	     zcbor_int32_put(zse, accel_summary->num_rejected);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode accel sample counts");
+		return -1;
+	}
+
+	ok = zcbor_map_end_encode(zse, 6);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to close accel map");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int encode_tilt_sensor_data(zcbor_state_t *zse, struct tilt_sensor *tilt_data)
+{
+	bool ok;
+
+	ok = zcbor_tstr_put_lit(zse, "tilt") && zcbor_map_start_encode(zse, 2);
+	if (!ok) {
+		LOG_ERR("ZCBOR unable to open tilt map");
+		return -1;
+	}
+
+	ok = zcbor_tstr_put_lit(zse, "pitch") &&
+	     app_real_put(zse, rad_to_deg(tilt_data->pitch_rad)) &&
+	     zcbor_tstr_put_lit(zse, "roll") &&
+	     app_real_put(zse, rad_to_deg(tilt_data->roll_rad));
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode tilt data");
+		return -1;
+	}
+
+	ok = zcbor_map_end_encode(zse, 2);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to close tilt map");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int encode_water_level_sensor_data(zcbor_state_t *zse,
+					  struct water_level_sensor *water_level_data)
+{
+	bool ok;
+
+	ok = zcbor_tstr_put_lit(zse, "water_level") && zcbor_map_start_encode(zse, 3);
+	if (!ok) {
+		LOG_ERR("ZCBOR unable to open water_level map");
+		return -1;
+	}
+
+	ok = zcbor_tstr_put_lit(zse, "float_length") &&
+	     app_real_put(zse, water_level_data->float_length_in) &&
+	     zcbor_tstr_put_lit(zse, "float_offset") &&
+	     app_real_put(zse, water_level_data->float_offset_in) &&
+	     zcbor_tstr_put_lit(zse, "float_height") &&
+	     app_real_put(zse, water_level_data->float_height_in);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode water_level data");
+		return -1;
+	}
+
+	ok = zcbor_map_end_encode(zse, 3);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to close water_level map");
+		return -1;
+	}
+
+	return 0;
+}
+
+static app_real_t json_safe_time(app_real_t value)
+{
+	if (isnan(value) || isinf(value)) {
+		return -1;
+	}
+	return value;
+}
+
+static int encode_battery_status_data(zcbor_state_t *zse, struct battery_status *battery_data)
+{
+	bool ok;
+
+	ok = zcbor_tstr_put_lit(zse, "battery") && zcbor_map_start_encode(zse, 6);
+	if (!ok) {
+		LOG_ERR("ZCBOR unable to open battery map");
+		return -1;
+	}
+
+	ok = zcbor_tstr_put_lit(zse, "voltage") &&
+	     app_real_put(zse, battery_data->voltage_v) &&
+	     zcbor_tstr_put_lit(zse, "current") &&
+	     app_real_put(zse, battery_data->current_a) && zcbor_tstr_put_lit(zse, "temp") &&
+	     app_real_put(zse, battery_data->temp_c) && zcbor_tstr_put_lit(zse, "soc") &&
+	     app_real_put(zse, battery_data->soc_pct) && zcbor_tstr_put_lit(zse, "tte") &&
+	     app_real_put(zse, json_safe_time(battery_data->tte_s)) &&
+	     zcbor_tstr_put_lit(zse, "ttf") &&
+	     app_real_put(zse, json_safe_time(battery_data->ttf_s));
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode battery data");
+		return -1;
+	}
+
+	ok = zcbor_map_end_encode(zse, 6);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to close battery map");
+		return -1;
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_APP_WAVES)
+static int encode_wave_data(zcbor_state_t *zse, struct wave_summary *wave_data)
+{
+	bool ok;
+
+	ok = zcbor_tstr_put_lit(zse, "waves") && zcbor_map_start_encode(zse, 3);
+	if (!ok) {
+		LOG_ERR("ZCBOR unable to open waves map");
+		return -1;
+	}
+
+	ok = zcbor_tstr_put_lit(zse, "hs") && zcbor_float32_put(zse, wave_data->sig_height_in) &&
+	     zcbor_tstr_put_lit(zse, "tp") && zcbor_float32_put(zse, wave_data->peak_period_s) &&
+	     zcbor_tstr_put_lit(zse, "peak") && zcbor_float32_put(zse, wave_data->peak_density);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode waves data");
+		return -1;
+	}
+
+	ok = zcbor_map_end_encode(zse, 3);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to close waves map");
+		return -1;
+	}
+
+	return 0;
+}
+#endif
+
+static bool get_reading_timestamp(const struct sensor_reading *reading, int64_t *unix_time_s)
+{
+#if defined(CONFIG_DATE_TIME)
+	int64_t unix_time_ms;
+
+	if (reading->uptime_ms == APP_SENSORS_UPTIME_UNKNOWN) {
+		return false;
+	}
+
+	if (date_time_now(&unix_time_ms) != 0) {
+		return false;
+	}
+
+	/* Back-date the current time by the age of the reading */
+	*unix_time_s = (unix_time_ms - (k_uptime_get() - reading->uptime_ms)) / MSEC_PER_SEC;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+static int encode_sensor_data_v1(zcbor_state_t *zse, struct sensor_reading *reading,
+				 bool with_timestamp)
+{
+	int64_t unix_time_s;
+	int err;
+	bool ok;
+
+	ok = zcbor_map_start_encode(zse, 6);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to open map");
+		return -1;
+	}
+
+	/* Readings without a timestamp are stamped with the time of arrival */
+	if (with_timestamp && get_reading_timestamp(reading, &unix_time_s)) {
+		ok = zcbor_tstr_put_lit(zse, "ts") && zcbor_uint64_put(zse, unix_time_s);
+		if (!ok) {
+			LOG_ERR("ZCBOR failed to encode timestamp");
+			return -1;
+		}
+	}
+
+	err = encode_accel_data(zse, &reading->accel, &reading->accel_summary);
+	if (err) {
+		return -1;
+	}
+
+	err = encode_tilt_sensor_data(zse, &reading->tilt);
+	if (err) {
+		return -1;
+	}
+
+	err = encode_water_level_sensor_data(zse, &reading->water_level);
+	if (err) {
+		return -1;
+	}
+
+	err = encode_battery_status_data(zse, &reading->battery);
+	if (err) {
+		return -1;
+	}
+
+#if defined(CONFIG_APP_WAVES)
+	if (reading->waves_valid) {
+		err = encode_wave_data(zse, &reading->waves);
+		if (err) {
+			return -1;
+		}
+	}
+#endif
+
+	ok = zcbor_map_end_encode(zse, 6);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to close map");
+		return -1;
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_APP_PAYLOAD_V2)
+/*
+ * Compact v2 payload: a flat map with integer keys. Values are encoded as
+ * half or single precision floats, or as scaled integers, depending on the
+ * precision needed. The float length and offset only change through the
+ * device settings, so they are only sent when they differ from the values
+ * last sent to Golioth.
+ */
+#define PAYLOAD_VERSION 2
+
+enum payload_key {
+	PAYLOAD_KEY_VERSION = 0,
+	PAYLOAD_KEY_TS = 1,
+	PAYLOAD_KEY_ACCEL_X = 2,
+	PAYLOAD_KEY_ACCEL_Y = 3,
+	PAYLOAD_KEY_ACCEL_Z = 4,
+	PAYLOAD_KEY_ACCEL_VAR = 5,
+	PAYLOAD_KEY_ACCEL_N = 6,
+	PAYLOAD_KEY_ACCEL_REJECTED = 7,
+	PAYLOAD_KEY_PITCH = 8,
+	PAYLOAD_KEY_ROLL = 9,
+	PAYLOAD_KEY_FLOAT_HEIGHT = 10,
+	PAYLOAD_KEY_FLOAT_LENGTH = 11,
+	PAYLOAD_KEY_FLOAT_OFFSET = 12,
+	PAYLOAD_KEY_VOLTAGE_MV = 13,
+	PAYLOAD_KEY_CURRENT_UA = 14,
+	PAYLOAD_KEY_TEMP_CC = 15,
+	PAYLOAD_KEY_SOC_CPCT = 16,
+	PAYLOAD_KEY_TTE = 17,
+	PAYLOAD_KEY_TTF = 18,
+	PAYLOAD_KEY_WAVES = 19,
+	PAYLOAD_KEY_COUNT,
+};
+
+struct payload_constants {
+	bool valid;
+	app_real_t float_length_in;
+	app_real_t float_offset_in;
+};
+
+/* Constants known to Golioth after the last payload that was sent */
+static struct payload_constants s_constants_sent;
+/* Constants known to Golioth once the payload being encoded is sent */
+static struct payload_constants s_constants_encoded;
+
+static inline int32_t scaled_int(app_real_t value, int32_t scale)
+{
+	return (int32_t)lroundf((float)value * (float)scale);
+}
+
+/* Check which constants must be sent, and mark them as known once this payload is sent */
+static void update_constants(const struct water_level_sensor *water_level, bool *send_length,
+			     bool *send_offset)
+{
+	*send_length = !s_constants_encoded.valid ||
+		       s_constants_encoded.float_length_in != water_level->float_length_in;
+	*send_offset = !s_constants_encoded.valid ||
+		       s_constants_encoded.float_offset_in != water_level->float_offset_in;
+
+	s_constants_encoded.valid = true;
+	s_constants_encoded.float_length_in = water_level->float_length_in;
+	s_constants_encoded.float_offset_in = water_level->float_offset_in;
+}
+
+static int encode_sensor_data_v2(zcbor_state_t *zse, struct sensor_reading *reading,
+				 bool with_timestamp)
+{
+	struct water_level_sensor *water_level = &reading->water_level;
+	struct battery_status *battery = &reading->battery;
+	bool send_length;
+	bool send_offset;
+	int64_t unix_time_s;
+	bool ok;
+
+	ok = zcbor_map_start_encode(zse, PAYLOAD_KEY_COUNT) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_VERSION) && zcbor_uint32_put(zse, PAYLOAD_VERSION);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to open map");
+		return -1;
+	}
+
+	if (with_timestamp && get_reading_timestamp(reading, &unix_time_s)) {
+		ok = zcbor_uint32_put(zse, PAYLOAD_KEY_TS) && zcbor_uint64_put(zse, unix_time_s);
+		if (!ok) {
+			LOG_ERR("ZCBOR failed to encode timestamp");
+			return -1;
+		}
+	}
+
+	ok = zcbor_uint32_put(zse, PAYLOAD_KEY_ACCEL_X) &&
+	     zcbor_float16_put(zse, reading->accel.x) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_ACCEL_Y) &&
+	     zcbor_float16_put(zse, reading->accel.y) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_ACCEL_Z) &&
+	     zcbor_float16_put(zse, reading->accel.z) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_ACCEL_VAR) && zcbor_list_start_encode(zse, 3) &&
+	     zcbor_float16_put(zse, reading->accel_summary.variance.x) &&
+	     zcbor_float16_put(zse, reading->accel_summary.variance.y) &&
+	     zcbor_float16_put(zse, reading->accel_summary.variance.z) &&
+	     zcbor_list_end_encode(zse, 3) && zcbor_uint32_put(zse, PAYLOAD_KEY_ACCEL_N) &&
+	     zcbor_int32_put(zse, reading->accel_summary.num_samples) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_ACCEL_REJECTED) &&
+	     zcbor_int32_put(zse, reading->accel_summary.num_rejected);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode accel data");
+		return -1;
+	}
+
+	ok = zcbor_uint32_put(zse, PAYLOAD_KEY_PITCH) &&
+	     zcbor_float32_put(zse, rad_to_deg(reading->tilt.pitch_rad)) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_ROLL) &&
+	     zcbor_float32_put(zse, rad_to_deg(reading->tilt.roll_rad)) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_FLOAT_HEIGHT) &&
+	     zcbor_float32_put(zse, water_level->float_height_in);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode water level data");
+		return -1;
+	}
+
+	update_constants(water_level, &send_length, &send_offset);
+
+	if (send_length) {
+		ok = zcbor_uint32_put(zse, PAYLOAD_KEY_FLOAT_LENGTH) &&
+		     zcbor_float32_put(zse, water_level->float_length_in);
+	}
+
+	if (ok && send_offset) {
+		ok = zcbor_uint32_put(zse, PAYLOAD_KEY_FLOAT_OFFSET) &&
+		     zcbor_float32_put(zse, water_level->float_offset_in);
+	}
+
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode water level constants");
+		return -1;
+	}
+
+	ok = zcbor_uint32_put(zse, PAYLOAD_KEY_VOLTAGE_MV) &&
+	     zcbor_int32_put(zse, scaled_int(battery->voltage_v, 1000)) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_CURRENT_UA) &&
+	     zcbor_int32_put(zse, scaled_int(battery->current_a, 1000000)) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_TEMP_CC) &&
+	     zcbor_int32_put(zse, scaled_int(battery->temp_c, 100)) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_SOC_CPCT) &&
+	     zcbor_int32_put(zse, scaled_int(battery->soc_pct, 100)) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_TTE) &&
+	     zcbor_int32_put(zse, scaled_int(json_safe_time(battery->tte_s), 1)) &&
+	     zcbor_uint32_put(zse, PAYLOAD_KEY_TTF) &&
+	     zcbor_int32_put(zse, scaled_int(json_safe_time(battery->ttf_s), 1));
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to encode battery data");
+		return -1;
+	}
+
+#if defined(CONFIG_APP_WAVES)
+	if (reading->waves_valid) {
+		ok = zcbor_uint32_put(zse, PAYLOAD_KEY_WAVES) && zcbor_list_start_encode(zse, 3) &&
+		     zcbor_float16_put(zse, reading->waves.sig_height_in) &&
+		     zcbor_float16_put(zse, reading->waves.peak_period_s) &&
+		     zcbor_float16_put(zse, reading->waves.peak_density) &&
+		     zcbor_list_end_encode(zse, 3);
+		if (!ok) {
+			LOG_ERR("ZCBOR failed to encode waves data");
+			return -1;
+		}
+	}
+#endif
+
+	ok = zcbor_map_end_encode(zse, PAYLOAD_KEY_COUNT);
+	if (!ok) {
+		LOG_ERR("ZCBOR failed to close map");
+		return -1;
+	}
+
+	return 0;
+}
+#endif
+
+int app_payload_encode(zcbor_state_t *zse, struct sensor_reading *reading, bool with_timestamp)
+{
+#if defined(CONFIG_APP_PAYLOAD_V2)
+	return encode_sensor_data_v2(zse, reading, with_timestamp);
+#else
+	return encode_sensor_data_v1(zse, reading, with_timestamp);
+#endif
+}
+
+int app_payload_encode_list(zcbor_state_t *zse, struct sensor_reading **readings, int count)
+{
+	if (!zcbor_list_start_encode(zse, count)) {
+		return -ENOMEM;
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (app_payload_encode(zse, readings[i], true)) {
+			return -ENOMEM;
+		}
+	}
+
+	if (!zcbor_list_end_encode(zse, count)) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+void app_payload_start(void)
+{
+#if defined(CONFIG_APP_PAYLOAD_V2)
+	s_constants_encoded = s_constants_sent;
+#endif
+}
+
+void app_payload_sent(void)
+{
+#if defined(CONFIG_APP_PAYLOAD_V2)
+	s_constants_sent = s_constants_encoded;
+#endif
+}
+
+#if defined(CONFIG_APP_PAYLOAD_SIZE_COMPARE)
+void app_payload_compare_size(struct sensor_reading *reading, size_t size)
+{
+	uint8_t cbor_buf[512];
+
+	ZCBOR_STATE_E(zse, 3, cbor_buf, sizeof(cbor_buf), 1);
+	if (encode_sensor_data_v1(zse, reading, false) == 0) {
+		LOG_INF("Payload size: v2 %zu bytes, v1 %zu bytes", size,
+			(size_t)(zse->payload - cbor_buf));
+	}
+}
+#endif
+
+#if defined(CONFIG_APP_BATCH_COMPRESSION)
+/*
+ * Compressed batch: each reading is converted to a row of scaled integer
+ * fields, which are delta encoded by app_codec.
+ */
+#define PACKED_CODEC_VERSION 1
+
+enum packed_field {
+	PACKED_FIELD_TS = 0, /* s */
+	PACKED_FIELD_ACCEL_X, /* mm/s^2 */
+	PACKED_FIELD_ACCEL_Y,
+	PACKED_FIELD_ACCEL_Z,
+	PACKED_FIELD_ACCEL_VAR_X, /* (mm/s^2)^2 */
+	PACKED_FIELD_ACCEL_VAR_Y,
+	PACKED_FIELD_ACCEL_VAR_Z,
+	PACKED_FIELD_ACCEL_N,
+	PACKED_FIELD_ACCEL_REJECTED,
+	PACKED_FIELD_PITCH, /* mdeg */
+	PACKED_FIELD_ROLL,
+	PACKED_FIELD_FLOAT_HEIGHT, /* 0.001 in */
+	PACKED_FIELD_FLOAT_LENGTH,
+	PACKED_FIELD_FLOAT_OFFSET,
+	PACKED_FIELD_VOLTAGE, /* mV */
+	PACKED_FIELD_CURRENT, /* uA */
+	PACKED_FIELD_TEMP, /* 0.01 degC */
+	PACKED_FIELD_SOC, /* 0.01 % */
+	PACKED_FIELD_TTE, /* s */
+	PACKED_FIELD_TTF,
+#if defined(CONFIG_APP_WAVES)
+	PACKED_FIELD_WAVES_HS, /* 0.001 in, 0 if not available */
+	PACKED_FIELD_WAVES_TP, /* ms */
+	PACKED_FIELD_WAVES_PEAK, /* 0.001 in^2/Hz */
+#endif
+	PACKED_FIELD_COUNT,
+};
+
+static uint8_t s_packed_buf[CONFIG_APP_BATCH_PACKED_BUF_SIZE];
+
+static int64_t packed_scale(app_real_t value, int32_t scale)
+{
+	return llroundf((float)value * (float)scale);
+}
+
+static int64_t packed_field(void *ctx, int index, int field)
+{
+	struct sensor_reading *reading = ((struct sensor_reading **)ctx)[index];
+	struct battery_status *battery = &reading->battery;
+	int64_t unix_time_s;
+
+	switch (field) {
+	case PACKED_FIELD_TS:
+		return get_reading_timestamp(reading, &unix_time_s) ? unix_time_s : 0;
+	case PACKED_FIELD_ACCEL_X:
+		return packed_scale(reading->accel.x, 1000);
+	case PACKED_FIELD_ACCEL_Y:
+		return packed_scale(reading->accel.y, 1000);
+	case PACKED_FIELD_ACCEL_Z:
+		return packed_scale(reading->accel.z, 1000);
+	case PACKED_FIELD_ACCEL_VAR_X:
+		return packed_scale(reading->accel_summary.variance.x, 1000000);
+	case PACKED_FIELD_ACCEL_VAR_Y:
+		return packed_scale(reading->accel_summary.variance.y, 1000000);
+	case PACKED_FIELD_ACCEL_VAR_Z:
+		return packed_scale(reading->accel_summary.variance.z, 1000000);
+	case PACKED_FIELD_ACCEL_N:
+		return reading->accel_summary.num_samples;
+	case PACKED_FIELD_ACCEL_REJECTED:
+		return reading->accel_summary.num_rejected;
+	case PACKED_FIELD_PITCH:
+		return packed_scale(rad_to_deg(reading->tilt.pitch_rad), 1000);
+	case PACKED_FIELD_ROLL:
+		return packed_scale(rad_to_deg(reading->tilt.roll_rad), 1000);
+	case PACKED_FIELD_FLOAT_HEIGHT:
+		return packed_scale(reading->water_level.float_height_in, 1000);
+	case PACKED_FIELD_FLOAT_LENGTH:
+		return packed_scale(reading->water_level.float_length_in, 1000);
+	case PACKED_FIELD_FLOAT_OFFSET:
+		return packed_scale(reading->water_level.float_offset_in, 1000);
+	case PACKED_FIELD_VOLTAGE:
+		return packed_scale(battery->voltage_v, 1000);
+	case PACKED_FIELD_CURRENT:
+		return packed_scale(battery->current_a, 1000000);
+	case PACKED_FIELD_TEMP:
+		return packed_scale(battery->temp_c, 100);
+	case PACKED_FIELD_SOC:
+		return packed_scale(battery->soc_pct, 100);
+	case PACKED_FIELD_TTE:
+		return packed_scale(json_safe_time(battery->tte_s), 1);
+	case PACKED_FIELD_TTF:
+		return packed_scale(json_safe_time(battery->ttf_s), 1);
+#if defined(CONFIG_APP_WAVES)
+	case PACKED_FIELD_WAVES_HS:
+		return reading->waves_valid ? packed_scale(reading->waves.sig_height_in, 1000) : 0;
+	case PACKED_FIELD_WAVES_TP:
+		return reading->waves_valid ? packed_scale(reading->waves.peak_period_s, 1000) : 0;
+	case PACKED_FIELD_WAVES_PEAK:
+		return reading->waves_valid ? packed_scale(reading->waves.peak_density, 1000) : 0;
+#endif
+	default:
+		return 0;
+	}
+}
+
+int app_payload_encode_packed(zcbor_state_t *zse, struct sensor_reading **readings, int count)
+{
+	size_t len;
+	bool ok;
+	int err;
+
+	err = app_codec_encode(packed_field, readings, count, PACKED_FIELD_COUNT, s_packed_buf,
+			       sizeof(s_packed_buf), &len);
+	if (err) {
+		return err;
+	}
+
+	ok = zcbor_list_start_encode(zse, 4) && zcbor_uint32_put(zse, PACKED_CODEC_VERSION) &&
+	     zcbor_uint32_put(zse, count) && zcbor_uint32_put(zse, PACKED_FIELD_COUNT) &&
+	     zcbor_bstr_encode_ptr(zse, s_packed_buf, len) && zcbor_list_end_encode(zse, 4);
+	if (!ok) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_APP_PAYLOAD_SELF_CHECK)
+void app_payload_check(const uint8_t *payload, size_t size)
+{
+	size_t decoded_size;
+	int err;
+
+#if defined(CONFIG_APP_PAYLOAD_V2)
+	struct sensor_payload_v2 decoded;
+
+	err = cbor_decode_sensor_payload_v2(payload, size, &decoded, &decoded_size);
+#else
+	struct sensor_payload_v1 decoded;
+
+	err = cbor_decode_sensor_payload_v1(payload, size, &decoded, &decoded_size);
+#endif
+	if (err != ZCBOR_SUCCESS || decoded_size != size) {
+		LOG_ERR("Sensor payload does not match the schema: %d", err);
+	}
+}
+#endif
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_PAYLOAD_H__
+#define __APP_PAYLOAD_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zcbor_common.h>
+
+#include "app_sensors.h"
+
+/*
+ * Encoding of sensor readings as CBOR payloads (see schema/sensor_payload.cddl).
+ *
+ * Payloads of one or more encoded readings must be bracketed by
+ * app_payload_start() and app_payload_sent() (once the payload has been sent),
+ * so fields which are only sent when they change are tracked correctly.
+ */
+void app_payload_start(void);
+void app_payload_sent(void);
+
+/* Encode a single reading (sensor-payload-v1 or sensor-payload-v2) */
+int app_payload_encode(zcbor_state_t *zse, struct sensor_reading *reading, bool with_timestamp);
+
+/* Encode an array of timestamped readings (sensor-batch-v1 or sensor-batch-v2) */
+int app_payload_encode_list(zcbor_state_t *zse, struct sensor_reading **readings, int count);
+
+#if defined(CONFIG_APP_BATCH_COMPRESSION)
+/* Encode a compressed batch of readings (see app_codec.h) */
+int app_payload_encode_packed(zcbor_state_t *zse, struct sensor_reading **readings, int count);
+#endif
+
+#if defined(CONFIG_APP_PAYLOAD_SIZE_COMPARE)
+/* Log the size of a v2 payload of size bytes next to the size of the same reading in v1 */
+void app_payload_compare_size(struct sensor_reading *reading, size_t size);
+#endif
+
+#if defined(CONFIG_APP_PAYLOAD_SELF_CHECK)
+/* Log an error if an encoded single reading payload does not match the schema */
+void app_payload_check(const uint8_t *payload, size_t size);
+#endif
+
+#endif /* __APP_PAYLOAD_H__ */
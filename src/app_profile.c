@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_profile.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <golioth/client.h>
+#include <golioth/stream.h>
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+LOG_MODULE_REGISTER(app_profile, CONFIG_APP_LOG_LEVEL);
+
+/* Bucket 0 counts durations under 1 ms, bucket i durations of [2^(i-1), 2^i) ms */
+#define PROFILE_HIST_BUCKETS 16
+
+struct profile_stats {
+	uint32_t count;
+	uint32_t min_us;
+	uint32_t max_us;
+	uint64_t total_us;
+	uint16_t hist[PROFILE_HIST_BUCKETS];
+};
+
+static const char *const s_phase_names[APP_PROFILE_NUM_PHASES] = {
+	[APP_PROFILE_CYCLE] = "cycle",
+	[APP_PROFILE_CONNECT] = "connect",
+	[APP_PROFILE_HANDSHAKE] = "handshake",
+	[APP_PROFILE_SETTINGS] = "settings",
+	[APP_PROFILE_ACCEL] = "accel",
+	[APP_PROFILE_FUEL_GAUGE] = "fuel_gauge",
+	[APP_PROFILE_ENCODE] = "encode",
+	[APP_PROFILE_STREAM] = "stream",
+	[APP_PROFILE_RRC] = "rrc",
+};
+
+static struct profile_stats s_stats[APP_PROFILE_NUM_PHASES];
+static struct k_spinlock s_lock;
+static int s_calls_since_upload;
+static uint32_t s_tx_bytes;
+
+static uint8_t s_cbor_buf[CONFIG_APP_PROFILE_CBOR_BUF_SIZE];
+
+static int hist_bucket(uint32_t duration_us)
+{
+	uint32_t duration_ms = duration_us / USEC_PER_MSEC;
+
+	if (duration_ms == 0) {
+		return 0;
+	}
+
+	return MIN(32 - __builtin_clz(duration_ms), PROFILE_HIST_BUCKETS - 1);
+}
+
+void app_profile_record(enum app_profile_phase phase, uint32_t duration_us)
+{
+	struct profile_stats *stats = &s_stats[phase];
+	k_spinlock_key_t key = k_spin_lock(&s_lock);
+	uint16_t *bucket = &stats->hist[hist_bucket(duration_us)];
+
+	if (stats->count == 0 || duration_us < stats->min_us) {
+		stats->min_us = duration_us;
+	}
+	if (duration_us > stats->max_us) {
+		stats->max_us = duration_us;
+	}
+	stats->count++;
+	stats->total_us += duration_us;
+	if (*bucket < UINT16_MAX) {
+		(*bucket)++;
+	}
+
+	k_spin_unlock(&s_lock, key);
+}
+
+void app_profile_add_tx_bytes(size_t size)
+{
+	k_spinlock_key_t key = k_spin_lock(&s_lock);
+
+	s_tx_bytes += size;
+
+	k_spin_unlock(&s_lock, key);
+}
+
+void app_profile_end(enum app_profile_phase phase, int64_t start)
+{
+	uint64_t duration_us = k_ticks_to_us_floor64(k_uptime_ticks() - start);
+
+	app_profile_record(phase, (uint32_t)MIN(duration_us, UINT32_MAX));
+}
+
+static bool encode_phase(zcbor_state_t *zse, const char *name, const struct profile_stats *stats)
+{
+	uint32_t mean_us = stats->count ? (uint32_t)(stats->total_us / stats->count) : 0;
+	int num_buckets = PROFILE_HIST_BUCKETS;
+	bool ok;
+
+	/* Trailing empty buckets are not sent */
+	while (num_buckets > 0 && stats->hist[num_buckets - 1] == 0) {
+		num_buckets--;
+	}
+
+	ok = zcbor_tstr_put_term(zse, name, SIZE_MAX) && zcbor_list_start_encode(zse, 5) &&
+	     zcbor_uint32_put(zse, stats->count) && zcbor_uint32_put(zse, stats->min_us) &&
+	     zcbor_uint32_put(zse, mean_us) && zcbor_uint32_put(zse, stats->max_us) &&
+	     zcbor_list_start_encode(zse, num_buckets);
+	for (int i = 0; ok && i < num_buckets; i++) {
+		ok = zcbor_uint32_put(zse, stats->hist[i]);
+	}
+
+	return ok && zcbor_list_end_encode(zse, num_buckets) && zcbor_list_end_encode(zse, 5);
+}
+
+static int encode_diagnostics(const struct profile_stats *stats, uint32_t tx_bytes,
+			      size_t *size)
+{
+	int num_phases = 0;
+	bool ok;
+
+	for (int i = 0; i < APP_PROFILE_NUM_PHASES; i++) {
+		if (stats[i].count) {
+			num_phases++;
+		}
+	}
+
+	ZCBOR_STATE_E(zse, 4, s_cbor_buf, sizeof(s_cbor_buf), 1);
+
+	ok = zcbor_map_start_encode(zse, 4) && zcbor_tstr_put_lit(zse, "v") &&
+	     zcbor_uint32_put(zse, 1) && zcbor_tstr_put_lit(zse, "up") &&
+	     zcbor_int64_put(zse, k_uptime_get() / MSEC_PER_SEC) &&
+	     zcbor_tstr_put_lit(zse, "tx") && zcbor_uint32_put(zse, tx_bytes) &&
+	     zcbor_tstr_put_lit(zse, "phases") && zcbor_map_start_encode(zse, num_phases);
+	for (int i = 0; ok && i < APP_PROFILE_NUM_PHASES; i++) {
+		if (stats[i].count) {
+			ok = encode_phase(zse, s_phase_names[i], &stats[i]);
+		}
+	}
+	ok = ok && zcbor_map_end_encode(zse, num_phases) && zcbor_map_end_encode(zse, 4);
+	if (!ok) {
+		LOG_ERR("Failed to encode diagnostics: %d", zcbor_peek_error(zse));
+		return -ENOMEM;
+	}
+
+	*size = zse->payload - s_cbor_buf;
+
+	return 0;
+}
+
+/* Add statistics which could not be sent back to those recorded since (lock held) */
+static void merge_stats(struct profile_stats *into, const struct profile_stats *from)
+{
+	if (from->count == 0) {
+		return;
+	}
+
+	if (into->count == 0 || from->min_us < into->min_us) {
+		into->min_us = from->min_us;
+	}
+	into->max_us = MAX(into->max_us, from->max_us);
+	into->count += from->count;
+	into->total_us += from->total_us;
+	for (int i = 0; i < PROFILE_HIST_BUCKETS; i++) {
+		into->hist[i] = MIN((uint32_t)into->hist[i] + from->hist[i], UINT16_MAX);
+	}
+}
+
+static void restore_stats(const struct profile_stats *stats, uint32_t tx_bytes)
+{
+	k_spinlock_key_t key = k_spin_lock(&s_lock);
+
+	for (int i = 0; i < APP_PROFILE_NUM_PHASES; i++) {
+		merge_stats(&s_stats[i], &stats[i]);
+	}
+	s_tx_bytes += tx_bytes;
+
+	k_spin_unlock(&s_lock, key);
+}
+
+int app_profile_stream(struct golioth_client *client)
+{
+	struct profile_stats stats[APP_PROFILE_NUM_PHASES];
+	uint32_t tx_bytes;
+	k_spinlock_key_t key;
+	size_t size;
+	int err;
+
+	if (++s_calls_since_upload < CONFIG_APP_PROFILE_UPLOAD_INTERVAL) {
+		return 0;
+	}
+
+	/* Phases recorded while the diagnostics are sent are kept for the next upload */
+	key = k_spin_lock(&s_lock);
+	memcpy(stats, s_stats, sizeof(stats));
+	tx_bytes = s_tx_bytes;
+	memset(s_stats, 0, sizeof(s_stats));
+	s_tx_bytes = 0;
+	k_spin_unlock(&s_lock, key);
+
+	err = encode_diagnostics(stats, tx_bytes, &size);
+	if (err) {
+		restore_stats(stats, tx_bytes);
+		return err;
+	}
+
+	err = golioth_stream_set_sync(client, "diag", GOLIOTH_CONTENT_TYPE_CBOR, s_cbor_buf, size,
+				      CONFIG_APP_GOLIOTH_STREAM_TIMEOUT_S);
+	if (err != GOLIOTH_OK) {
+		LOG_ERR("Failed to send diagnostics to Golioth: %d", err);
+		restore_stats(stats, tx_bytes);
+		return -EIO;
+	}
+
+	LOG_INF("Sent %zu bytes of diagnostics to Golioth", size);
+
+	s_calls_since_upload = 0;
+
+	return 0;
+}
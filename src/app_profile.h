@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_PROFILE_H__
+#define __APP_PROFILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <golioth/client.h>
+#include <zephyr/kernel.h>
+
+/* Wake cycle phases, in the order they are reported (see schema/diagnostics.cddl) */
+enum app_profile_phase {
+	/* Wake cycle which connected to Golioth */
+	APP_PROFILE_CYCLE,
+	/* LTE wake up and connection to Golioth */
+	APP_PROFILE_CONNECT,
+	/* DTLS handshake */
+	APP_PROFILE_HANDSHAKE,
+	/* Waiting for settings updates */
+	APP_PROFILE_SETTINGS,
+	/* Accelerometer burst */
+	APP_PROFILE_ACCEL,
+	/* Fuel gauge update */
+	APP_PROFILE_FUEL_GAUGE,
+	/* CBOR encoding of the sensor data */
+	APP_PROFILE_ENCODE,
+	/* Stream round trip to Golioth */
+	APP_PROFILE_STREAM,
+	/* Time in RRC connected mode (CONFIG_APP_RAI) */
+	APP_PROFILE_RRC,
+	APP_PROFILE_NUM_PHASES,
+};
+
+#if defined(CONFIG_APP_PROFILE)
+/* Returns the start time of a phase, to pass to app_profile_end() */
+static inline int64_t app_profile_start(void)
+{
+	return k_uptime_ticks();
+}
+
+void app_profile_end(enum app_profile_phase phase, int64_t start);
+
+void app_profile_record(enum app_profile_phase phase, uint32_t duration_us);
+
+/* Count the payload bytes sent in stream round trips */
+void app_profile_add_tx_bytes(size_t size);
+
+/*
+ * Stream the phase statistics to the Golioth "diag" path every
+ * CONFIG_APP_PROFILE_UPLOAD_INTERVAL calls, and reset them once sent.
+ */
+int app_profile_stream(struct golioth_client *client);
+#else
+static inline int64_t app_profile_start(void)
+{
+	return 0;
+}
+
+static inline void app_profile_end(enum app_profile_phase phase, int64_t start)
+{
+}
+
+static inline void app_profile_record(enum app_profile_phase phase, uint32_t duration_us)
+{
+}
+
+static inline void app_profile_add_tx_bytes(size_t size)
+{
+}
+#endif
+
+#endif /* __APP_PROFILE_H__ */
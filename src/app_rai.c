@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_rai.h"
+
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/socket_ncs.h>
+
+LOG_MODULE_REGISTER(app_rai, CONFIG_APP_LOG_LEVEL);
+
+static struct k_spinlock s_lock;
+
+/* Uptime of the last RRC connection (-1 while idle) */
+static int64_t s_rrc_connected_ms = -1;
+/* Time spent in RRC connected mode which has not been reported yet */
+static int64_t s_rrc_total_ms;
+
+void app_rai_event(const struct lte_lc_evt *const evt)
+{
+	k_spinlock_key_t key;
+	int64_t now_ms = k_uptime_get();
+
+	if (evt->type != LTE_LC_EVT_RRC_UPDATE) {
+		return;
+	}
+
+	key = k_spin_lock(&s_lock);
+
+	if (evt->rrc_mode == LTE_LC_RRC_MODE_CONNECTED) {
+		if (s_rrc_connected_ms < 0) {
+			s_rrc_connected_ms = now_ms;
+		}
+	} else if (s_rrc_connected_ms >= 0) {
+		s_rrc_total_ms += now_ms - s_rrc_connected_ms;
+		s_rrc_connected_ms = -1;
+	}
+
+	k_spin_unlock(&s_lock, key);
+}
+
+int64_t app_rai_rrc_connected_ms(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&s_lock);
+	int64_t now_ms = k_uptime_get();
+	int64_t connected_ms = s_rrc_total_ms;
+
+	/* Count an ongoing connection up to now */
+	if (s_rrc_connected_ms >= 0) {
+		connected_ms += now_ms - s_rrc_connected_ms;
+		s_rrc_connected_ms = now_ms;
+	}
+	s_rrc_total_ms = 0;
+
+	k_spin_unlock(&s_lock, key);
+
+	return connected_ms;
+}
+
+int app_rai_release(void)
+{
+	int rai = RAI_NO_DATA;
+	int err = 0;
+	int fd;
+
+	/*
+	 * The Golioth client owns its socket, so the indication is sent on a
+	 * socket of its own. RAI_NO_DATA takes effect immediately, without
+	 * sending a packet.
+	 */
+	fd = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (fd < 0) {
+		err = -errno;
+		LOG_ERR("Failed to open socket for RAI: %d", err);
+		return err;
+	}
+
+	if (zsock_setsockopt(fd, SOL_SOCKET, SO_RAI, &rai, sizeof(rai)) < 0) {
+		err = -errno;
+		LOG_ERR("Failed to send Release Assistance Indication: %d", err);
+	} else {
+		LOG_INF("Sent Release Assistance Indication");
+	}
+
+	zsock_close(fd);
+
+	return err;
+}
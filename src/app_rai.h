@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_RAI_H__
+#define __APP_RAI_H__
+
+#include <stdint.h>
+
+#include <modem/lte_lc.h>
+
+/* Track the time spent in RRC connected mode from the RRC update events */
+void app_rai_event(const struct lte_lc_evt *const evt);
+
+/*
+ * Indicate to the network that no more data is expected (Release Assistance
+ * Indication), so the RRC connection is released right away instead of when
+ * the network inactivity timer expires.
+ */
+int app_rai_release(void);
+
+/* Returns the time spent in RRC connected mode since the last call */
+int64_t app_rai_rrc_connected_ms(void);
+
+#endif /* __APP_RAI_H__ */
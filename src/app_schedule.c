@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_schedule.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_DATE_TIME)
+#include <date_time.h>
+#endif
+
+LOG_MODULE_REGISTER(app_schedule, CONFIG_APP_LOG_LEVEL);
+
+#define COALESCE_MS ((int64_t)CONFIG_APP_SCHEDULE_COALESCE_S * MSEC_PER_SEC)
+
+struct schedule_job {
+	uint32_t period_s;
+	/* Uptime of the next run */
+	int64_t next_ms;
+	bool triggered;
+};
+
+static struct schedule_job s_jobs[APP_SCHEDULE_NUM_JOBS];
+static struct k_spinlock s_lock;
+/* Set once the jobs have been aligned to wall-clock time */
+static bool s_wall_clock_aligned;
+
+K_SEM_DEFINE(schedule_wake_sem, 0, 1);
+
+static void wake_work_handler(struct k_work *work)
+{
+	k_sem_give(&schedule_wake_sem);
+}
+
+static K_WORK_DELAYABLE_DEFINE(s_wake_work, wake_work_handler);
+
+/* Offset to add to the uptime to get the wall-clock time */
+static int64_t wall_clock_offset_ms(void)
+{
+#if defined(CONFIG_DATE_TIME)
+	int64_t unix_time_ms;
+
+	if (date_time_now(&unix_time_ms) == 0) {
+		return unix_time_ms - k_uptime_get();
+	}
+#endif
+
+	return 0;
+}
+
+/* Uptime of the first slot of the period strictly after the given uptime */
+static int64_t next_slot_ms(uint32_t period_s, int64_t after_ms, int64_t offset_ms)
+{
+	int64_t period_ms = (int64_t)period_s * MSEC_PER_SEC;
+	int64_t wall_ms = after_ms + offset_ms;
+
+	return (wall_ms / period_ms + 1) * period_ms - offset_ms;
+}
+
+void app_schedule_set_period(enum app_schedule_job job, uint32_t period_s)
+{
+	int64_t offset_ms = wall_clock_offset_ms();
+	k_spinlock_key_t key = k_spin_lock(&s_lock);
+
+	s_jobs[job].period_s = period_s;
+	if (period_s > 0) {
+		s_jobs[job].next_ms = next_slot_ms(period_s, k_uptime_get(), offset_ms);
+	}
+
+	k_spin_unlock(&s_lock, key);
+
+	LOG_INF("Job %d period set to %u s", job, period_s);
+
+	/* Let a waiting thread pick up the new schedule */
+	k_sem_give(&schedule_wake_sem);
+}
+
+void app_schedule_trigger(enum app_schedule_job job)
+{
+	k_spinlock_key_t key = k_spin_lock(&s_lock);
+
+	s_jobs[job].triggered = true;
+
+	k_spin_unlock(&s_lock, key);
+
+	k_sem_give(&schedule_wake_sem);
+}
+
+/*
+ * Jobs are scheduled in uptime until the time is known, so move the jobs which
+ * are not due yet to their wall-clock aligned slots once it is (lock held).
+ */
+static void align_to_wall_clock(int64_t now_ms, int64_t offset_ms)
+{
+	if (s_wall_clock_aligned || offset_ms == 0) {
+		return;
+	}
+
+	for (int i = 0; i < APP_SCHEDULE_NUM_JOBS; i++) {
+		struct schedule_job *job = &s_jobs[i];
+
+		if (job->period_s > 0 && job->next_ms > now_ms) {
+			job->next_ms = next_slot_ms(job->period_s, now_ms, offset_ms);
+		}
+	}
+
+	s_wall_clock_aligned = true;
+
+	LOG_INF("Schedule aligned to wall-clock time");
+}
+
+/* Returns the due jobs, or sets the uptime of the next wake if none are due */
+static uint32_t collect_due_jobs(int64_t now_ms, int64_t offset_ms, int64_t *wake_ms)
+{
+	uint32_t due = 0;
+
+	*wake_ms = INT64_MAX;
+
+	for (int i = 0; i < APP_SCHEDULE_NUM_JOBS; i++) {
+		struct schedule_job *job = &s_jobs[i];
+
+		if (job->triggered) {
+			*wake_ms = now_ms;
+		} else if (job->period_s > 0) {
+			*wake_ms = MIN(*wake_ms, job->next_ms);
+		}
+	}
+
+	if (*wake_ms > now_ms) {
+		return 0;
+	}
+
+	for (int i = 0; i < APP_SCHEDULE_NUM_JOBS; i++) {
+		struct schedule_job *job = &s_jobs[i];
+
+		if (job->triggered) {
+			job->triggered = false;
+			due |= BIT(i);
+		}
+
+		/* Pull jobs which are due soon into this wake */
+		if (job->period_s > 0 && job->next_ms <= now_ms + COALESCE_MS) {
+			job->next_ms =
+				next_slot_ms(job->period_s, MAX(now_ms, job->next_ms), offset_ms);
+			due |= BIT(i);
+		}
+	}
+
+	return due;
+}
+
+uint32_t app_schedule_wait(void)
+{
+	while (true) {
+		int64_t offset_ms = wall_clock_offset_ms();
+		int64_t now_ms = k_uptime_get();
+		int64_t wake_ms;
+		uint32_t due;
+		k_spinlock_key_t key = k_spin_lock(&s_lock);
+
+		align_to_wall_clock(now_ms, offset_ms);
+		due = collect_due_jobs(now_ms, offset_ms, &wake_ms);
+
+		k_spin_unlock(&s_lock, key);
+
+		if (due) {
+			LOG_DBG("Running jobs 0x%x", due);
+			return due;
+		}
+
+		if (wake_ms != INT64_MAX) {
+			LOG_DBG("Next wake in %lld ms", wake_ms - now_ms);
+			k_work_reschedule(&s_wake_work, K_MSEC(wake_ms - now_ms));
+		}
+
+		k_sem_take(&schedule_wake_sem, K_FOREVER);
+	}
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_SCHEDULE_H__
+#define __APP_SCHEDULE_H__
+
+#include <stdint.h>
+
+enum app_schedule_job {
+	/* Take a reading (every STREAM_DELAY_S seconds) */
+	APP_SCHEDULE_MEASURE,
+	/* Connect to Golioth to receive settings and OTA updates */
+	APP_SCHEDULE_SYNC,
+	/* Upload pending readings, if there are any (only triggered) */
+	APP_SCHEDULE_FLUSH,
+	APP_SCHEDULE_NUM_JOBS,
+};
+
+/*
+ * Set the period of a job (0 disables it). The job runs at the next multiple
+ * of the period in wall-clock time (or uptime, until the time is known). This
+ * may be called from any thread, and does not interrupt a cycle in progress.
+ */
+void app_schedule_set_period(enum app_schedule_job job, uint32_t period_s);
+
+/* Run a job as soon as possible, without moving its next scheduled run */
+void app_schedule_trigger(enum app_schedule_job job);
+
+/*
+ * Wait until at least one job is due, and return the bit mask of the due jobs.
+ * Jobs due within CONFIG_APP_SCHEDULE_COALESCE_S of each other are returned
+ * together, so they share a single wake.
+ */
+uint32_t app_schedule_wait(void);
+
+#endif /* __APP_SCHEDULE_H__ */
@@ -17,9 +17,30 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/logging/log.h>
+#if defined(CONFIG_APP_ACCEL_FIFO)
+#include <zephyr/rtio/rtio.h>
+#endif
+#if defined(CONFIG_APP_MATH_BENCHMARK)
+#include <zephyr/timing/timing.h>
+#endif
 
+#if defined(CONFIG_APP_ACCEL_FILTER)
+#include "app_accel_filter.h"
+#endif
+#if defined(CONFIG_APP_BACKLOG)
+#include "app_backlog.h"
+#endif
 #include "app_battery.h"
+#if defined(CONFIG_APP_HEIGHT_TABLE)
+#include "app_fast_math.h"
+#endif
+#include "app_payload.h"
+#include "app_profile.h"
 #include "app_settings.h"
+#include "app_stats.h"
+#if defined(CONFIG_APP_ACTIVITY_WAKE)
+#include "main.h"
+#endif
 
 LOG_MODULE_REGISTER(app_sensors, CONFIG_APP_LOG_LEVEL);
 
@@ -37,17 +58,206 @@ LOG_MODULE_REGISTER(app_sensors, CONFIG_APP_LOG_LEVEL);
 
 static struct golioth_client *s_client;
 
+struct accel_stats {
+	/* Unfiltered samples after outlier rejection (the reported variance) */
+	struct app_stats x;
+	struct app_stats y;
+	struct app_stats z;
+	/* Per-sample unfiltered pitch, only tracked when early stopping is enabled */
+	struct app_stats pitch;
+	app_real_t pitch_tolerance_rad;
+	float sample_rate_hz;
+	int max_samples;
+	int num_read;
+	int num_rejected;
+	/* Last accepted sample, which replaces rejected samples at the filter input */
+	struct accel_xyz last_accepted;
+#if defined(CONFIG_APP_ACCEL_FILTER)
+	/* Low-pass filtered samples (the estimate), when the filter is enabled */
+	struct app_stats filtered_x;
+	struct app_stats filtered_y;
+	struct app_stats filtered_z;
+	struct app_accel_filter filter;
+	bool filter_enabled;
+#endif
+};
+
+/* Staging buffer used to process accelerometer samples block-wise */
+struct accel_block {
+	app_real_t x[CONFIG_APP_ACCEL_BLOCK_SIZE];
+	app_real_t y[CONFIG_APP_ACCEL_BLOCK_SIZE];
+	app_real_t z[CONFIG_APP_ACCEL_BLOCK_SIZE];
+	int count;
+};
+
+/*
+ * The accelerometer can be selected with the "app,accel" chosen node (e.g. an
+ * emulated device), otherwise the ADXL367 is used.
+ */
+#if DT_HAS_CHOSEN(app_accel)
+#define ACCEL_NODE DT_CHOSEN(app_accel)
+#else
+#define ACCEL_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(adi_adxl367)
+#endif
+
 /* Sensor device structs */
-static const struct device *const s_accel = DEVICE_DT_GET_ONE(adi_adxl367);
+static const struct device *const s_accel = DEVICE_DT_GET(ACCEL_NODE);
+
+#if defined(CONFIG_APP_ACCEL_FIFO)
+/*
+ * Stream the accelerometer FIFO contents each time the FIFO watermark
+ * interrupt fires. The whole FIFO batch is delivered in a single RTIO
+ * completion, so the CPU only wakes once per batch instead of once per sample.
+ */
+SENSOR_DT_STREAM_IODEV(s_accel_iodev, ACCEL_NODE,
+		       {SENSOR_TRIG_FIFO_WATERMARK, SENSOR_STREAM_DATA_INCLUDE});
+RTIO_DEFINE_WITH_MEMPOOL(s_accel_rtio, 1, 1, CONFIG_APP_ACCEL_FIFO_BUF_BLOCKS, 64,
+			 sizeof(void *));
+
+/* The ADXL367 FIFO holds 512 samples, i.e. 170 XYZ sample sets */
+#define ACCEL_FIFO_MAX_SETS 170
+
+/*
+ * FIFO watermark (in XYZ sample sets) from the "fifo-watermark" devicetree
+ * property (in samples). A full FIFO is assumed if it is not set.
+ */
+#define ACCEL_FIFO_WATERMARK_SETS                                                                  \
+	(DT_PROP_OR(ACCEL_NODE, fifo_watermark, 3 * ACCEL_FIFO_MAX_SETS) / 3)
+
+BUILD_ASSERT(ACCEL_FIFO_WATERMARK_SETS <= ACCEL_FIFO_MAX_SETS,
+	     "Accelerometer FIFO watermark exceeds the FIFO size");
+
+/* Time allowed for the FIFO to deliver a batch on top of the time to fill it */
+#define ACCEL_FIFO_TIMEOUT_MARGIN_MS 500
+
+/* Output data rates supported by the ADXL367 (in mHz) */
+static const int32_t s_accel_odr_mhz[] = {12500, 25000, 50000, 100000, 200000, 400000};
+#endif
+
+#if defined(CONFIG_APP_ACTIVITY_WAKE)
+static int64_t s_last_measurement_time;
+static atomic_t s_sampling;
+
+static void accel_activity_handler(const struct device *dev, const struct sensor_trigger *trig)
+{
+	int64_t elapsed_ms = k_uptime_get() - s_last_measurement_time;
+
+	/* Motion during a measurement is expected, so ignore it */
+	if (atomic_get(&s_sampling)) {
+		return;
+	}
+
+	if (elapsed_ms < (CONFIG_APP_ACTIVITY_WAKE_MIN_INTERVAL_S * MSEC_PER_SEC)) {
+		LOG_DBG("Float arm motion detected %lld ms after the last measurement, ignoring",
+			elapsed_ms);
+		return;
+	}
+
+	LOG_INF("Float arm motion detected, waking system thread");
+	wake_system_thread();
+}
+
+static int enable_activity_wake(void)
+{
+	struct sensor_trigger trig = {
+		.type = SENSOR_TRIG_THRESHOLD,
+		.chan = SENSOR_CHAN_ACCEL_XYZ,
+	};
+	struct sensor_value threshold;
+	int err;
+
+	if (!device_is_ready(s_accel)) {
+		LOG_ERR("%s is not ready", s_accel->name);
+		return -ENODEV;
+	}
+
+	sensor_ug_to_ms2(CONFIG_APP_ACTIVITY_WAKE_THRESHOLD_MG * 1000, &threshold);
+
+	err = sensor_attr_set(s_accel, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_UPPER_THRESH,
+			      &threshold);
+	if (err) {
+		LOG_ERR("Unable to set accelerometer activity threshold: %d", err);
+		return err;
+	}
+
+	err = sensor_trigger_set(s_accel, &trig, accel_activity_handler);
+	if (err) {
+		LOG_ERR("Unable to set accelerometer activity trigger: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_APP_OVERLAP_SAMPLING)
+K_THREAD_STACK_DEFINE(s_sampling_stack, CONFIG_APP_SAMPLING_STACK_SIZE);
+static struct k_work_q s_sampling_work_q;
+static struct k_work s_sampling_work;
+static K_SEM_DEFINE(s_sampling_done, 0, 1);
+static struct sensor_reading s_async_reading;
+static int s_async_err;
+static bool s_async_pending;
+
+static void sampling_work_handler(struct k_work *work)
+{
+	s_async_err = app_sensors_read(&s_async_reading);
+	k_sem_give(&s_sampling_done);
+}
+
+void app_sensors_read_start(void)
+{
+	if (s_async_pending) {
+		return;
+	}
+
+	k_sem_reset(&s_sampling_done);
+	s_async_pending = true;
+	k_work_submit_to_queue(&s_sampling_work_q, &s_sampling_work);
+}
+
+int app_sensors_read_finish(struct sensor_reading *reading)
+{
+	if (!s_async_pending) {
+		return -EALREADY;
+	}
+
+	k_sem_take(&s_sampling_done, K_FOREVER);
+	s_async_pending = false;
+
+	if (reading == NULL) {
+		LOG_WRN("Discarding sensor reading");
+		return 0;
+	}
+
+	if (s_async_err == 0) {
+		*reading = s_async_reading;
+	}
+
+	return s_async_err;
+}
+#endif
 
 void app_sensors_init(struct golioth_client *client)
 {
 	s_client = client;
+
+#if defined(CONFIG_APP_OVERLAP_SAMPLING)
+	k_work_queue_start(&s_sampling_work_q, s_sampling_stack,
+			   K_THREAD_STACK_SIZEOF(s_sampling_stack),
+			   CONFIG_APP_SAMPLING_THREAD_PRIORITY, NULL);
+	k_thread_name_set(&s_sampling_work_q.thread, "app_sampling");
+	k_work_init(&s_sampling_work, sampling_work_handler);
+#endif
+
+#if defined(CONFIG_APP_ACTIVITY_WAKE)
+	enable_activity_wake();
+#endif
 }
 
-static inline double rad_to_deg(double rad)
+static inline app_real_t rad_to_deg(app_real_t rad)
 {
-	return rad * (180.0 / M_PI);
+	return rad * APP_REAL(180.0 / M_PI);
 }
 
 static int read_accel_sensor(struct accel_xyz *accel_data)
@@ -72,9 +282,9 @@ static int read_accel_sensor(struct accel_xyz *accel_data)
 	sensor_channel_get(s_accel, SENSOR_CHAN_ACCEL_Z, &accel_z);
 
 	/* Raw accelerometer output values in m/s² */
-	double x = sensor_value_to_double(&accel_x);
-	double y = sensor_value_to_double(&accel_y);
-	double z = sensor_value_to_double(&accel_z);
+	app_real_t x = sensor_value_to_app_real(&accel_x);
+	app_real_t y = sensor_value_to_app_real(&accel_y);
+	app_real_t z = sensor_value_to_app_real(&accel_z);
 
 	accel_data->x = x;
 	accel_data->y = y;
@@ -83,305 +293,792 @@ static int read_accel_sensor(struct accel_xyz *accel_data)
 	return 0;
 }
 
-static void calculate_tilt(struct accel_xyz *accel_data, struct tilt_sensor *tilt_data)
+static inline float accel_polled_rate_hz(int sample_delay_ms)
 {
-	double x = accel_data->x;
-	double y = accel_data->y;
-	double z = accel_data->z;
-
-	/* A positive tilt angle means that the corresponding positive axis of
-	 * the accelerometer is pointed above the horizon, whereas a negative
-	 * angle means that the axis is pointed below the horizon. However, the
-	 * low-power accelerometer (ADXL367) on the Thingy:91 X is located on
-	 * the bottom side of the board, so the axis are reversed relative to
-	 * the horizon and the acceleration due to gravity is measured as a
-	 * negative value. As a result, the sign of the tilt angles needs to be
-	 * reversed.
-	 *
-	 * The accelerometer positive X-axis points in the direction from the
-	 * USB port towards the power switch. The accelerometer positive Y-axis
-	 * points in the direction looking into the USB port.
-	 *
-	 * Assumptions:
-	 * 1. The Thingy:91 X is installed right-side up, i.e. the yellow half
-	 *    of the enclosure is on the bottom facing the earth and the orange
-	 *    half of the enclosure is on the top facing the sky.
-	 * 2. The Thingy:91 X is installed with the USB connector pointing down
-	 *    the pivot arm in the direction of the float.
-	 */
-	tilt_data->roll_rad = -atan2(x, sqrt(y * y + z * z));
-	tilt_data->pitch_rad = -atan2(y, sqrt(x * x + z * z));
+	/* A zero sample delay polls the accelerometer at its maximum rate */
+	return (sample_delay_ms > 0) ? (1000.0f / sample_delay_ms) : 400.0f;
 }
 
-static void calculate_water_level(struct tilt_sensor *tilt_data,
-				  struct water_level_sensor *water_level_data)
+static void accel_stats_init(struct accel_stats *stats, int max_samples, float sample_rate_hz,
+			     app_real_t pitch_tolerance_deg)
 {
-	double float_length_in = (double)get_float_length_in();
-	double float_offset_in = (double)get_float_offset_in();
-	double pitch_rad = tilt_data->pitch_rad;
+	app_stats_init(&stats->x, APP_REAL(0.5));
+	app_stats_init(&stats->y, APP_REAL(0.5));
+	app_stats_init(&stats->z, APP_REAL(0.5));
+	app_stats_init(&stats->pitch, APP_REAL(0.5));
+	stats->pitch_tolerance_rad = pitch_tolerance_deg * APP_REAL(M_PI / 180.0);
+	stats->sample_rate_hz = sample_rate_hz;
+	stats->max_samples = max_samples;
+	stats->num_read = 0;
+	stats->num_rejected = 0;
 
-	/* Calculate the height of the float relative to the hinge */
-	water_level_data->float_length_in = float_length_in;
-	water_level_data->float_offset_in = float_offset_in;
-	water_level_data->float_height_in = float_length_in * sin(pitch_rad) + float_offset_in;
+#if defined(CONFIG_APP_ACCEL_FILTER)
+	app_stats_init(&stats->filtered_x, APP_REAL(0.5));
+	app_stats_init(&stats->filtered_y, APP_REAL(0.5));
+	app_stats_init(&stats->filtered_z, APP_REAL(0.5));
+	stats->filter_enabled =
+		(app_accel_filter_init(&stats->filter, sample_rate_hz,
+				       CONFIG_APP_ACCEL_FILTER_CUTOFF_MHZ / 1000.0f) == 0);
+#endif
+
+#if defined(CONFIG_APP_WAVES)
+	app_waves_reset();
+#endif
 }
 
-static int encode_accel_data(zcbor_state_t *zse, struct accel_xyz *accel_data)
+/*
+ * Sampling stops after ACCEL_NUM_SAMPLES samples, or earlier once the standard
+ * error of the mean pitch drops below ACCEL_PITCH_TOLERANCE_DEG.
+ *
+ * The standard error is estimated from the unfiltered pitch. The low-pass
+ * filtered samples are strongly autocorrelated, so variance / n over them
+ * would understate the standard error and stop sampling far too early.
+ */
+static bool accel_sampling_done(const struct accel_stats *stats)
 {
-	bool ok;
+	app_real_t tolerance = stats->pitch_tolerance_rad;
+	uint32_t count = stats->pitch.count;
+
+	if (stats->num_read >= stats->max_samples) {
+		return true;
+	}
 
-	ok = zcbor_tstr_put_lit(zse, "accel") && zcbor_map_start_encode(zse, 3);
-	if (!ok) {
-		LOG_ERR("ZCBOR unable to open accel map");
-		return -1;
+#if defined(CONFIG_APP_WAVES)
+	/* Keep sampling until there are enough samples for the wave spectrum */
+	if (!app_waves_is_full()) {
+		return false;
 	}
+#endif
 
-	ok = zcbor_tstr_put_lit(zse, "x") && zcbor_float64_put(zse, accel_data->x) &&
-	     zcbor_tstr_put_lit(zse, "y") && zcbor_float64_put(zse, accel_data->y) &&
-	     zcbor_tstr_put_lit(zse, "z") && zcbor_float64_put(zse, accel_data->z);
-	if (!ok) {
-		LOG_ERR("ZCBOR failed to encode accel data");
-		return -1;
+	if (tolerance <= APP_REAL(0) || count < CONFIG_APP_ACCEL_EARLY_STOP_MIN_SAMPLES) {
+		return false;
 	}
 
-	ok = zcbor_map_end_encode(zse, 3);
-	if (!ok) {
-		LOG_ERR("ZCBOR failed to close accel map");
-		return -1;
+	/* Standard error of the mean: sqrt(variance / n) < tolerance */
+	return app_stats_variance(&stats->pitch) < (tolerance * tolerance * (app_real_t)count);
+}
+
+/*
+ * Outliers are rejected on the unfiltered samples, before the low-pass filter
+ * would smear them into the neighbouring samples. A rejected sample is replaced
+ * with the last accepted one, so the filter still sees evenly spaced samples.
+ */
+static bool reject_accel_outlier(struct accel_stats *stats, struct accel_block *block, int i)
+{
+	const app_real_t sigma = APP_REAL(CONFIG_APP_ACCEL_OUTLIER_SIGMA_X10) / APP_REAL(10);
+	const uint32_t min_count = CONFIG_APP_ACCEL_OUTLIER_MIN_SAMPLES;
+
+	/* Reject the whole sample if any axis is an outlier (e.g. a wave hit) */
+	if (app_stats_is_outlier(&stats->x, block->x[i], sigma, min_count) ||
+	    app_stats_is_outlier(&stats->y, block->y[i], sigma, min_count) ||
+	    app_stats_is_outlier(&stats->z, block->z[i], sigma, min_count)) {
+		block->x[i] = stats->last_accepted.x;
+		block->y[i] = stats->last_accepted.y;
+		block->z[i] = stats->last_accepted.z;
+		return true;
 	}
 
-	return 0;
+	app_stats_add(&stats->x, block->x[i]);
+	app_stats_add(&stats->y, block->y[i]);
+	app_stats_add(&stats->z, block->z[i]);
+
+	stats->last_accepted.x = block->x[i];
+	stats->last_accepted.y = block->y[i];
+	stats->last_accepted.z = block->z[i];
+
+	return false;
 }
 
-static int encode_tilt_sensor_data(zcbor_state_t *zse, struct tilt_sensor *tilt_data)
+static void accumulate_accel_sample(struct accel_stats *stats,
+				    const struct accel_xyz *accel_sample, bool rejected,
+				    app_real_t raw_pitch)
 {
-	bool ok;
+	int sample_num = stats->num_read++;
 
-	ok = zcbor_tstr_put_lit(zse, "tilt") && zcbor_map_start_encode(zse, 2);
-	if (!ok) {
-		LOG_ERR("ZCBOR unable to open tilt map");
-		return -1;
+	LOG_DBG("Sample %d: X: %.6f, Y: %.6f, Z: %.6f", sample_num, (double)accel_sample->x,
+		(double)accel_sample->y, (double)accel_sample->z);
+
+	if (rejected) {
+		LOG_DBG("Sample %d rejected as an outlier", sample_num);
+		stats->num_rejected++;
+		return;
 	}
 
-	ok = zcbor_tstr_put_lit(zse, "pitch") &&
-	     zcbor_float64_put(zse, rad_to_deg(tilt_data->pitch_rad)) &&
-	     zcbor_tstr_put_lit(zse, "roll") &&
-	     zcbor_float64_put(zse, rad_to_deg(tilt_data->roll_rad));
-	if (!ok) {
-		LOG_ERR("ZCBOR failed to encode tilt data");
-		return -1;
+#if defined(CONFIG_APP_ACCEL_FILTER)
+	if (stats->filter_enabled) {
+		app_stats_add(&stats->filtered_x, accel_sample->x);
+		app_stats_add(&stats->filtered_y, accel_sample->y);
+		app_stats_add(&stats->filtered_z, accel_sample->z);
 	}
+#endif
 
-	ok = zcbor_map_end_encode(zse, 2);
-	if (!ok) {
-		LOG_ERR("ZCBOR failed to close tilt map");
-		return -1;
+	if (stats->pitch_tolerance_rad > APP_REAL(0)) {
+		app_stats_add(&stats->pitch, raw_pitch);
 	}
+}
 
-	return 0;
+static void accel_block_add(struct accel_block *block, const struct accel_xyz *accel_sample)
+{
+	block->x[block->count] = accel_sample->x;
+	block->y[block->count] = accel_sample->y;
+	block->z[block->count] = accel_sample->z;
+	block->count++;
 }
 
-static int encode_water_level_sensor_data(zcbor_state_t *zse,
-					  struct water_level_sensor *water_level_data)
+static void flush_accel_block(struct accel_stats *stats, struct accel_block *block)
 {
-	bool ok;
+	/* Unfiltered pitch of each sample, for early stopping and the waves */
+	app_real_t pitch[CONFIG_APP_ACCEL_BLOCK_SIZE] = {0};
+	bool rejected[CONFIG_APP_ACCEL_BLOCK_SIZE];
+	/* Samples past the end of the burst (e.g. the rest of a FIFO batch) are ignored */
+	int count = MIN(block->count, stats->max_samples - stats->num_read);
+
+	if (IS_ENABLED(CONFIG_APP_WAVES) || (stats->pitch_tolerance_rad > APP_REAL(0))) {
+		for (int i = 0; i < block->count; i++) {
+			/* Same convention as calculate_tilt() */
+			app_real_t x = block->x[i];
+			app_real_t y = block->y[i];
+			app_real_t z = block->z[i];
+
+			pitch[i] = -app_atan2(y, app_sqrt(x * x + z * z));
+#if defined(CONFIG_APP_WAVES)
+			/* The waves are captured before the filter removes them */
+			app_waves_add_sample(pitch[i]);
+#endif
+		}
+	}
+
+	for (int i = 0; i < count; i++) {
+		rejected[i] = reject_accel_outlier(stats, block, i);
+	}
 
-	ok = zcbor_tstr_put_lit(zse, "water_level") && zcbor_map_start_encode(zse, 3);
-	if (!ok) {
-		LOG_ERR("ZCBOR unable to open water_level map");
-		return -1;
+#if defined(CONFIG_APP_ACCEL_FILTER)
+	if (stats->filter_enabled) {
+		app_accel_filter_process(&stats->filter, block->x, block->y, block->z,
+					 block->count);
 	}
+#endif
+
+	for (int i = 0; (i < count) && !accel_sampling_done(stats); i++) {
+		struct accel_xyz accel_sample = {
+			.x = block->x[i],
+			.y = block->y[i],
+			.z = block->z[i],
+		};
 
-	ok = zcbor_tstr_put_lit(zse, "float_length") &&
-	     zcbor_float64_put(zse, water_level_data->float_length_in) &&
-	     zcbor_tstr_put_lit(zse, "float_offset") &&
-	     zcbor_float64_put(zse, water_level_data->float_offset_in) &&
-	     zcbor_tstr_put_lit(zse, "float_height") &&
-	     zcbor_float64_put(zse, water_level_data->float_height_in);
-	if (!ok) {
-		LOG_ERR("ZCBOR failed to encode water_level data");
-		return -1;
+		accumulate_accel_sample(stats, &accel_sample, rejected[i], pitch[i]);
 	}
 
-	ok = zcbor_map_end_encode(zse, 3);
-	if (!ok) {
-		LOG_ERR("ZCBOR failed to close water_level map");
-		return -1;
+	block->count = 0;
+}
+
+static int read_accel_samples_polled(int sample_delay_ms, struct accel_stats *stats)
+{
+	struct accel_block block = {0};
+	struct accel_xyz accel_sample;
+	int err;
+
+	while (!accel_sampling_done(stats)) {
+		err = read_accel_sensor(&accel_sample);
+		if (err) {
+			return err;
+		}
+
+		accel_block_add(&block, &accel_sample);
+		flush_accel_block(stats, &block);
+
+		k_sleep(K_MSEC(sample_delay_ms));
 	}
 
 	return 0;
 }
 
-static double json_safe_time(double value)
+#if defined(CONFIG_APP_ACCEL_FIFO)
+/* Supported output data rate closest to the rate set by the sample delay (in mHz) */
+static int32_t accel_fifo_odr_mhz(int sample_delay_ms)
 {
-	if (isnan(value) || isinf(value)) {
-		return -1;
+	/* A zero sample delay runs the accelerometer at its maximum rate */
+	int64_t requested_mhz = (sample_delay_ms > 0) ? (1000000LL / sample_delay_ms) : INT32_MAX;
+	int32_t odr_mhz = s_accel_odr_mhz[0];
+
+	for (size_t i = 1; i < ARRAY_SIZE(s_accel_odr_mhz); i++) {
+		if (llabs(s_accel_odr_mhz[i] - requested_mhz) <= llabs(odr_mhz - requested_mhz)) {
+			odr_mhz = s_accel_odr_mhz[i];
+		}
+	}
+
+	return odr_mhz;
+}
+
+static int set_accel_odr(int32_t odr_mhz)
+{
+	struct sensor_value odr = {
+		.val1 = odr_mhz / 1000,
+		.val2 = (odr_mhz % 1000) * 1000,
+	};
+	int err;
+
+	err = sensor_attr_set(s_accel, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY,
+			      &odr);
+	if (err) {
+		LOG_ERR("Unable to set accelerometer ODR to %d.%d Hz: %d", odr.val1,
+			odr.val2 / 100000, err);
+		return err;
 	}
-	return value;
+
+	LOG_DBG("Accelerometer ODR: %d.%d Hz", odr.val1, odr.val2 / 100000);
+
+	return 0;
 }
 
-static int encode_battery_status_data(zcbor_state_t *zse, struct battery_status *battery_data)
+/*
+ * The ODR is snapped to a rate the ADXL367 supports, which changes the length of
+ * the sampling window set by ACCEL_NUM_SAMPLES and ACCEL_SAMPLE_DELAY_MS (e.g.
+ * 100 samples at a 100 ms delay take 8 s at 12.5 Hz instead of 10 s). Log it
+ * on the first reading and whenever the sample delay setting changes.
+ */
+static void log_accel_odr(int sample_delay_ms, int32_t odr_mhz, int num_samples)
 {
-	bool ok;
+	static int s_logged_delay_ms = -1;
 
-	ok = zcbor_tstr_put_lit(zse, "battery") && zcbor_map_start_encode(zse, 6);
-	if (!ok) {
-		LOG_ERR("ZCBOR unable to open battery map");
-		return -1;
+	if (sample_delay_ms == s_logged_delay_ms) {
+		return;
 	}
 
-	ok = zcbor_tstr_put_lit(zse, "voltage") &&
-	     zcbor_float64_put(zse, battery_data->voltage_v) &&
-	     zcbor_tstr_put_lit(zse, "current") &&
-	     zcbor_float64_put(zse, battery_data->current_a) && zcbor_tstr_put_lit(zse, "temp") &&
-	     zcbor_float64_put(zse, battery_data->temp_c) && zcbor_tstr_put_lit(zse, "soc") &&
-	     zcbor_float64_put(zse, battery_data->soc_pct) && zcbor_tstr_put_lit(zse, "tte") &&
-	     zcbor_float64_put(zse, json_safe_time(battery_data->tte_s)) &&
-	     zcbor_tstr_put_lit(zse, "ttf") &&
-	     zcbor_float64_put(zse, json_safe_time(battery_data->ttf_s));
-	if (!ok) {
-		LOG_ERR("ZCBOR failed to encode battery data");
-		return -1;
+	s_logged_delay_ms = sample_delay_ms;
+
+	LOG_INF("Accelerometer ODR %d.%d Hz for a %d ms sample delay: %d samples take %lld ms",
+		odr_mhz / 1000, (odr_mhz % 1000) / 100, sample_delay_ms, num_samples,
+		num_samples * 1000000LL / odr_mhz);
+}
+
+/* Release any completions left over from a cancelled stream */
+static void drain_accel_fifo(void)
+{
+	struct rtio_cqe *cqe;
+	uint8_t *buf;
+	uint32_t buf_len;
+
+	while ((cqe = rtio_cqe_consume(&s_accel_rtio)) != NULL) {
+		if (cqe->result == 0 &&
+		    rtio_cqe_get_mempool_buffer(&s_accel_rtio, cqe, &buf, &buf_len) == 0) {
+			rtio_release_buffer(&s_accel_rtio, buf, buf_len);
+		}
+		rtio_cqe_release(&s_accel_rtio, cqe);
 	}
+}
 
-	ok = zcbor_map_end_encode(zse, 6);
-	if (!ok) {
-		LOG_ERR("ZCBOR failed to close battery map");
-		return -1;
+/*
+ * Block until the FIFO watermark interrupt completes a batch, or until the
+ * deadline. The RTIO context gives its consume semaphore for each completion
+ * (CONFIG_RTIO_CONSUME_SEM), which rtio_cqe_consume() then takes.
+ */
+static struct rtio_cqe *wait_accel_fifo(int64_t deadline_ms)
+{
+	struct k_poll_event event = K_POLL_EVENT_INITIALIZER(
+		K_POLL_TYPE_SEM_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, s_accel_rtio.consume_sem);
+
+	if (k_poll(&event, 1, K_TIMEOUT_ABS_MS(deadline_ms)) != 0) {
+		return NULL;
 	}
 
-	return 0;
+	return rtio_cqe_consume(&s_accel_rtio);
 }
 
-static int encode_sensor_data(zcbor_state_t *zse, struct accel_xyz *accel_data,
-			      struct tilt_sensor *tilt_data,
-			      struct water_level_sensor *water_level_data,
-			      struct battery_status *battery_data)
+static int read_accel_samples_fifo(int sample_delay_ms, struct accel_stats *stats)
 {
+	const struct sensor_decoder_api *decoder;
+	struct accel_block block = {0};
+	struct rtio_sqe *handle;
+	int32_t odr_mhz = accel_fifo_odr_mhz(sample_delay_ms);
+	int64_t fill_ms;
+	int64_t deadline_ms;
 	int err;
-	bool ok;
 
-	ok = zcbor_map_start_encode(zse, 4);
-	if (!ok) {
-		LOG_ERR("ZCBOR failed to open map");
-		return -1;
+	if (stats->max_samples > ACCEL_FIFO_MAX_SETS) {
+		LOG_WRN("%d accelerometer samples do not fit in the FIFO (max %d)",
+			stats->max_samples, ACCEL_FIFO_MAX_SETS);
+		return -EINVAL;
 	}
 
-	err = encode_accel_data(zse, accel_data);
+	if (!device_is_ready(s_accel)) {
+		LOG_ERR("%s is not ready", s_accel->name);
+		return -ENODEV;
+	}
+
+	err = sensor_get_decoder(s_accel, &decoder);
 	if (err) {
-		return -1;
+		LOG_ERR("Unable to get accelerometer decoder: %d", err);
+		return err;
 	}
 
-	err = encode_tilt_sensor_data(zse, tilt_data);
+	err = set_accel_odr(odr_mhz);
 	if (err) {
-		return -1;
+		return err;
+	}
+
+	log_accel_odr(sample_delay_ms, odr_mhz, stats->max_samples);
+
+	drain_accel_fifo();
+
+	err = sensor_stream(&s_accel_iodev, &s_accel_rtio, NULL, &handle);
+	if (err) {
+		LOG_ERR("Unable to start accelerometer FIFO stream: %d", err);
+		return err;
+	}
+
+	/*
+	 * All samples arrive within the time it takes to fill the FIFO to the
+	 * watermark (or with all samples, if more), plus a margin. A missed
+	 * watermark interrupt times out and falls back to polling.
+	 */
+	fill_ms = MAX(stats->max_samples, ACCEL_FIFO_WATERMARK_SETS) * 1000000LL / odr_mhz;
+	deadline_ms = k_uptime_get() + fill_ms + ACCEL_FIFO_TIMEOUT_MARGIN_MS;
+
+	while (!accel_sampling_done(stats)) {
+		struct sensor_three_axis_data accel_frame;
+		struct rtio_cqe *cqe;
+		uint8_t *buf;
+		uint32_t buf_len;
+
+		cqe = wait_accel_fifo(deadline_ms);
+		if (cqe == NULL) {
+			LOG_ERR("Timed out waiting for the accelerometer FIFO");
+			err = -ETIMEDOUT;
+			break;
+		}
+
+		err = cqe->result;
+		if (err == 0) {
+			err = rtio_cqe_get_mempool_buffer(&s_accel_rtio, cqe, &buf, &buf_len);
+		}
+		rtio_cqe_release(&s_accel_rtio, cqe);
+		if (err) {
+			LOG_ERR("Accelerometer FIFO stream error: %d", err);
+			break;
+		}
+
+		struct sensor_decode_context ctx =
+			SENSOR_DECODE_CONTEXT_INIT(decoder, buf, SENSOR_CHAN_ACCEL_XYZ, 0);
+
+		while (sensor_decode(&ctx, &accel_frame, 1) > 0) {
+			/* Decoded values are Q31 scaled by 2^shift (in m/s²) */
+			struct accel_xyz accel_sample = {
+				.x = app_ldexp(accel_frame.readings[0].x,
+					       accel_frame.shift - 31),
+				.y = app_ldexp(accel_frame.readings[0].y,
+					       accel_frame.shift - 31),
+				.z = app_ldexp(accel_frame.readings[0].z,
+					       accel_frame.shift - 31),
+			};
+
+			accel_block_add(&block, &accel_sample);
+			if (block.count == CONFIG_APP_ACCEL_BLOCK_SIZE) {
+				flush_accel_block(stats, &block);
+			}
+		}
+
+		flush_accel_block(stats, &block);
+
+		rtio_release_buffer(&s_accel_rtio, buf, buf_len);
 	}
 
-	err = encode_water_level_sensor_data(zse, water_level_data);
+	rtio_sqe_cancel(handle);
+	drain_accel_fifo();
+
+	LOG_DBG("Read %d samples from the accelerometer FIFO", stats->num_read);
+
 	if (err) {
-		return -1;
+		return err;
 	}
 
-	err = encode_battery_status_data(zse, battery_data);
+	return accel_sampling_done(stats) ? 0 : -EIO;
+}
+#endif
+
+static app_real_t accel_stats_estimate(const struct app_stats *stats)
+{
+#if defined(CONFIG_APP_ACCEL_ESTIMATOR_MEDIAN)
+	return app_stats_quantile(stats);
+#else
+	return app_stats_mean(stats);
+#endif
+}
+
+static int read_accel_average(const struct app_settings_snapshot *settings,
+			      struct accel_xyz *accel_data, struct accel_summary *accel_summary)
+{
+	int accel_num_samples = settings->accel_num_samples;
+	int accel_sample_delay_ms = settings->accel_sample_delay_ms;
+	app_real_t accel_pitch_tolerance_deg = (app_real_t)settings->accel_pitch_tolerance_deg;
+	struct accel_stats stats;
+	int err;
+
+#if defined(CONFIG_APP_ACCEL_FIFO)
+	accel_stats_init(&stats, accel_num_samples,
+			 accel_fifo_odr_mhz(accel_sample_delay_ms) / 1000.0f,
+			 accel_pitch_tolerance_deg);
+	err = read_accel_samples_fifo(accel_sample_delay_ms, &stats);
 	if (err) {
-		return -1;
+		LOG_WRN("Accelerometer FIFO unavailable, falling back to polling");
+
+		accel_stats_init(&stats, accel_num_samples,
+				 accel_polled_rate_hz(accel_sample_delay_ms),
+				 accel_pitch_tolerance_deg);
+		err = read_accel_samples_polled(accel_sample_delay_ms, &stats);
+	}
+#else
+	accel_stats_init(&stats, accel_num_samples, accel_polled_rate_hz(accel_sample_delay_ms),
+			 accel_pitch_tolerance_deg);
+	err = read_accel_samples_polled(accel_sample_delay_ms, &stats);
+#endif
+	if (err) {
+		return err;
 	}
 
-	ok = zcbor_map_end_encode(zse, 4);
-	if (!ok) {
-		LOG_ERR("ZCBOR failed to close map");
-		return -1;
+#if defined(CONFIG_APP_ACCEL_FILTER)
+	if (stats.filter_enabled) {
+		accel_data->x = accel_stats_estimate(&stats.filtered_x);
+		accel_data->y = accel_stats_estimate(&stats.filtered_y);
+		accel_data->z = accel_stats_estimate(&stats.filtered_z);
+	} else
+#endif
+	{
+		accel_data->x = accel_stats_estimate(&stats.x);
+		accel_data->y = accel_stats_estimate(&stats.y);
+		accel_data->z = accel_stats_estimate(&stats.z);
 	}
 
+	/* The variance is reported for the unfiltered samples, see struct accel_summary */
+
+	accel_summary->variance.x = app_stats_variance(&stats.x);
+	accel_summary->variance.y = app_stats_variance(&stats.y);
+	accel_summary->variance.z = app_stats_variance(&stats.z);
+	accel_summary->num_samples = stats.num_read;
+	accel_summary->num_rejected = stats.num_rejected;
+	accel_summary->sample_rate_hz = stats.sample_rate_hz;
+
+	LOG_DBG("X range: [%.6f, %.6f], Y range: [%.6f, %.6f], Z range: [%.6f, %.6f]",
+		(double)stats.x.min, (double)stats.x.max, (double)stats.y.min,
+		(double)stats.y.max, (double)stats.z.min, (double)stats.z.max);
+
 	return 0;
 }
 
-/* This will be called by the main() loop after delays or on button presses */
-/* Do all of your work here! */
-void app_sensors_read_and_stream(void)
+static void calculate_tilt(struct accel_xyz *accel_data, struct tilt_sensor *tilt_data)
 {
-	int err;
-	int accel_num_samples = get_accel_num_samples();
-	int accel_sample_delay_ms = get_accel_sample_delay_ms();
-	char cbor_buf[512];
-	struct accel_xyz accel_sample, accel_data;
-	struct tilt_sensor tilt_data;
-	struct water_level_sensor water_level_data;
-	struct battery_status battery_data;
+	app_real_t x = accel_data->x;
+	app_real_t y = accel_data->y;
+	app_real_t z = accel_data->z;
 
-	/* Average accelerometer samples */
-	accel_data.x = 0;
-	accel_data.y = 0;
-	accel_data.z = 0;
+	/* A positive tilt angle means that the corresponding positive axis of
+	 * the accelerometer is pointed above the horizon, whereas a negative
+	 * angle means that the axis is pointed below the horizon. However, the
+	 * low-power accelerometer (ADXL367) on the Thingy:91 X is located on
+	 * the bottom side of the board, so the axis are reversed relative to
+	 * the horizon and the acceleration due to gravity is measured as a
+	 * negative value. As a result, the sign of the tilt angles needs to be
+	 * reversed.
+	 *
+	 * The accelerometer positive X-axis points in the direction from the
+	 * USB port towards the power switch. The accelerometer positive Y-axis
+	 * points in the direction looking into the USB port.
+	 *
+	 * Assumptions:
+	 * 1. The Thingy:91 X is installed right-side up, i.e. the yellow half
+	 *    of the enclosure is on the bottom facing the earth and the orange
+	 *    half of the enclosure is on the top facing the sky.
+	 * 2. The Thingy:91 X is installed with the USB connector pointing down
+	 *    the pivot arm in the direction of the float.
+	 */
+	tilt_data->roll_rad = -app_atan2(x, app_sqrt(y * y + z * z));
+	tilt_data->pitch_rad = -app_atan2(y, app_sqrt(x * x + z * z));
+}
 
-	for (int i = 0; i < accel_num_samples; i++) {
-		err = read_accel_sensor(&accel_sample);
-		if (err) {
-			return;
-		}
+static void calculate_water_level(const struct app_settings_snapshot *settings,
+				  struct tilt_sensor *tilt_data,
+				  struct water_level_sensor *water_level_data)
+{
+	app_real_t float_length_in = (app_real_t)settings->float_length_in;
+	app_real_t float_offset_in = (app_real_t)settings->float_offset_in;
+	app_real_t pitch_rad = tilt_data->pitch_rad;
 
-		if (i == 0) {
-			accel_data.x = accel_sample.x;
-			accel_data.y = accel_sample.y;
-			accel_data.z = accel_sample.z;
-		} else {
-			accel_data.x += accel_sample.x;
-			accel_data.y += accel_sample.y;
-			accel_data.z += accel_sample.z;
-		}
+	/* Calculate the height of the float relative to the hinge */
+	water_level_data->float_length_in = float_length_in;
+	water_level_data->float_offset_in = float_offset_in;
+#if defined(CONFIG_APP_HEIGHT_TABLE)
+	/* Calculate it directly if the table is not built for these settings yet */
+	if (app_height_table_lookup(float_length_in, float_offset_in, pitch_rad,
+				    &water_level_data->float_height_in) == 0) {
+		return;
+	}
+#endif
+	water_level_data->float_height_in = float_length_in * app_sin(pitch_rad) + float_offset_in;
+}
 
-		LOG_DBG("Sample %d: X: %.6f, Y: %.6f, Z: %.6f", i, accel_sample.x, accel_sample.y,
-			accel_sample.z);
+#if defined(CONFIG_APP_MATH_BENCHMARK)
+/*
+ * Compare the cost of the double and single precision versions of the tilt and
+ * water level calculations on the same accelerometer reading, and report how
+ * far apart the resulting float heights are.
+ */
+static void benchmark_math(const struct app_settings_snapshot *settings,
+			   const struct accel_xyz *accel_data)
+{
+	const int iterations = CONFIG_APP_MATH_BENCHMARK_ITERATIONS;
+	volatile double height_d = 0.0;
+	volatile float height_f = 0.0f;
+	timing_t start, end;
+	uint64_t double_cycles;
+	uint64_t float_cycles;
+
+	timing_init();
+	timing_start();
+
+	start = timing_counter_get();
+	for (int i = 0; i < iterations; i++) {
+		double x = (double)accel_data->x;
+		double y = (double)accel_data->y;
+		double z = (double)accel_data->z;
+		double pitch_rad = -atan2(y, sqrt(x * x + z * z));
+
+		height_d = (double)settings->float_length_in * sin(pitch_rad) +
+			   (double)settings->float_offset_in;
+	}
+	end = timing_counter_get();
+	double_cycles = timing_cycles_get(&start, &end) / iterations;
+
+	start = timing_counter_get();
+	for (int i = 0; i < iterations; i++) {
+		float x = (float)accel_data->x;
+		float y = (float)accel_data->y;
+		float z = (float)accel_data->z;
+		float pitch_rad = -atan2f(y, sqrtf(x * x + z * z));
+
+		height_f = settings->float_length_in * sinf(pitch_rad) + settings->float_offset_in;
+	}
+	end = timing_counter_get();
+	float_cycles = timing_cycles_get(&start, &end) / iterations;
+
+	timing_stop();
+
+	LOG_INF("Math benchmark: double %llu cycles, float %llu cycles, height error: %.6f in",
+		double_cycles, float_cycles, fabs(height_d - (double)height_f));
+}
+#endif
+
+#if defined(CONFIG_APP_REPORT_BY_EXCEPTION)
+static bool s_reported;
+static int64_t s_last_report_time;
+static app_real_t s_last_report_height_in;
+static app_real_t s_last_report_soc_pct;
+
+bool app_sensors_report_needed(const struct sensor_reading *reading)
+{
+	struct app_settings_snapshot settings;
+	int64_t heartbeat_ms;
+	app_real_t height_delta = reading->water_level.float_height_in - s_last_report_height_in;
+	app_real_t soc_delta = reading->battery.soc_pct - s_last_report_soc_pct;
+
+	app_settings_snapshot(&settings);
+	heartbeat_ms = (int64_t)settings.report_heartbeat_s * MSEC_PER_SEC;
+
+	if (!s_reported) {
+		return true;
+	}
+
+	if ((k_uptime_get() - s_last_report_time) >= heartbeat_ms) {
+		LOG_INF("Heartbeat interval elapsed, reporting");
+		return true;
+	}
 
-		k_sleep(K_MSEC(accel_sample_delay_ms));
+	/* Compare against the last reported values so slow drift is not missed */
+	if (app_fabs(height_delta) > settings.report_height_deadband_in) {
+		LOG_INF("Float height changed by %.2f in, reporting", (double)height_delta);
+		return true;
 	}
 
-	accel_data.x /= accel_num_samples;
-	accel_data.y /= accel_num_samples;
-	accel_data.z /= accel_num_samples;
+	if (app_fabs(soc_delta) > settings.report_soc_deadband_pct) {
+		LOG_INF("Battery SoC changed by %.2f%%, reporting", (double)soc_delta);
+		return true;
+	}
+
+	return false;
+}
+
+static void record_report(const struct sensor_reading *reading)
+{
+	s_reported = true;
+	s_last_report_time = k_uptime_get();
+	s_last_report_height_in = reading->water_level.float_height_in;
+	s_last_report_soc_pct = reading->battery.soc_pct;
+}
+#endif
+
+int app_sensors_read(struct sensor_reading *reading)
+{
+	struct app_settings_snapshot settings;
+	int64_t phase_start;
+	int err;
+	struct accel_xyz *accel_data = &reading->accel;
+	struct accel_summary *accel_summary = &reading->accel_summary;
+	struct tilt_sensor *tilt_data = &reading->tilt;
+	struct water_level_sensor *water_level_data = &reading->water_level;
+
+	reading->uptime_ms = k_uptime_get();
+
+	/* Use the same settings for the whole reading */
+	app_settings_snapshot(&settings);
+
+	/* Average accelerometer samples */
+	phase_start = app_profile_start();
+#if defined(CONFIG_APP_ACTIVITY_WAKE)
+	atomic_set(&s_sampling, 1);
+	err = read_accel_average(&settings, accel_data, accel_summary);
+	s_last_measurement_time = k_uptime_get();
+	atomic_set(&s_sampling, 0);
+
+	/* Re-arm the activity interrupt (the FIFO stream may have replaced it) */
+	enable_activity_wake();
+#else
+	err = read_accel_average(&settings, accel_data, accel_summary);
+#endif
+	app_profile_end(APP_PROFILE_ACCEL, phase_start);
+	if (err) {
+		return err;
+	}
 
 	/* Calculate tilt and water level from accelerometer data */
-	calculate_tilt(&accel_data, &tilt_data);
-	calculate_water_level(&tilt_data, &water_level_data);
+	calculate_tilt(accel_data, tilt_data);
+	calculate_water_level(&settings, tilt_data, water_level_data);
+
+#if defined(CONFIG_APP_WAVES)
+	/* Summarize the wave spectrum from the captured pitch time series */
+	reading->waves_valid =
+		(app_waves_analyze(accel_summary->sample_rate_hz,
+				   (float)water_level_data->float_length_in, &reading->waves) == 0);
+#endif
+
+#if defined(CONFIG_APP_MATH_BENCHMARK)
+	benchmark_math(&settings, accel_data);
+#endif
+
+#if defined(CONFIG_APP_ACCEL_FILTER_BENCHMARK)
+	app_accel_filter_benchmark();
+#endif
 
 	/* Read battery status */
-	fuel_gauge_sample(&battery_data);
+	phase_start = app_profile_start();
+	fuel_gauge_sample(&reading->battery);
+	app_profile_end(APP_PROFILE_FUEL_GAUGE, phase_start);
 
-	LOG_INF("X: %.6f; Y: %.6f; Z: %.6f", accel_data.x, accel_data.y, accel_data.z);
-	LOG_INF("roll: %.2f°, pitch: %.2f°", rad_to_deg(tilt_data.roll_rad),
-		rad_to_deg(tilt_data.pitch_rad));
+	LOG_INF("X: %.6f; Y: %.6f; Z: %.6f", (double)accel_data->x, (double)accel_data->y,
+		(double)accel_data->z);
+	LOG_INF("X var: %.6f; Y var: %.6f; Z var: %.6f; samples: %d; rejected: %d",
+		(double)accel_summary->variance.x, (double)accel_summary->variance.y,
+		(double)accel_summary->variance.z, accel_summary->num_samples,
+		accel_summary->num_rejected);
+	LOG_INF("roll: %.2f°, pitch: %.2f°", (double)rad_to_deg(tilt_data->roll_rad),
+		(double)rad_to_deg(tilt_data->pitch_rad));
 	LOG_INF("float length: %.2f in, float offset: %.2f in, float height: %.2f in",
-		water_level_data.float_length_in, water_level_data.float_offset_in,
-		water_level_data.float_height_in);
+		(double)water_level_data->float_length_in,
+		(double)water_level_data->float_offset_in,
+		(double)water_level_data->float_height_in);
+
+	return 0;
+}
+
+int app_sensors_stream(struct sensor_reading *reading)
+{
+	struct app_settings_snapshot settings;
+	int64_t phase_start;
+	int err;
+	char cbor_buf[512];
 
 	/* Only stream sensor data if connected */
-	if (golioth_client_is_connected(s_client)) {
-		/* Encode data as CBOR */
-		ZCBOR_STATE_E(zse, 3, cbor_buf, sizeof(cbor_buf), 1);
-		err = encode_sensor_data(zse, &accel_data, &tilt_data, &water_level_data,
-					 &battery_data);
-		if (err) {
-			return;
-		}
-		size_t cbor_size = zse->payload - (const uint8_t *)cbor_buf;
-
-		/*
-		 * Send to LightDB Stream on the "sensor" endpoint.
-		 * Since the client is stopped manually right after sending,
-		 * it's simplest to just use the sync stream variant to block
-		 * until a response is received or a timeout occurs (if async is
-		 * used, the client needs to be kept running until a response is
-		 * received).
-		 */
-		err = golioth_stream_set_sync(s_client, "sensor", GOLIOTH_CONTENT_TYPE_CBOR,
-					      cbor_buf, cbor_size,
-					      CONFIG_APP_GOLIOTH_STREAM_TIMEOUT_S);
-		if (err != GOLIOTH_OK) {
-			LOG_ERR("Failed to send sensor data to Golioth: %d", err);
-		} else {
-			LOG_INF("Sent sensor data to Golioth");
-		}
-	} else {
+	if (!golioth_client_is_connected(s_client)) {
+#if defined(CONFIG_APP_BACKLOG)
+		LOG_WRN("No connection available, storing sensor data in backlog");
+		app_backlog_store(reading);
+#else
 		LOG_WRN("No connection available, skipping sending sensor data to Golioth");
+#endif
+		return -ENOTCONN;
+	}
+
+	/* The float length & offset settings may have changed since the reading */
+	app_settings_snapshot(&settings);
+	calculate_water_level(&settings, &reading->tilt, &reading->water_level);
+
+	/* Encode data as CBOR */
+	ZCBOR_STATE_E(zse, 3, cbor_buf, sizeof(cbor_buf), 1);
+	app_payload_start();
+	phase_start = app_profile_start();
+	err = app_payload_encode(zse, reading, false);
+	app_profile_end(APP_PROFILE_ENCODE, phase_start);
+	if (err) {
+		return -EINVAL;
+	}
+	size_t cbor_size = zse->payload - (const uint8_t *)cbor_buf;
+
+#if defined(CONFIG_APP_PAYLOAD_SIZE_COMPARE)
+	app_payload_compare_size(reading, cbor_size);
+#endif
+#if defined(CONFIG_APP_PAYLOAD_SELF_CHECK)
+	app_payload_check((const uint8_t *)cbor_buf, cbor_size);
+#endif
+
+	/*
+	 * Send to LightDB Stream on the "sensor" endpoint.
+	 * Since the client is stopped manually right after sending,
+	 * it's simplest to just use the sync stream variant to block
+	 * until a response is received or a timeout occurs (if async is
+	 * used, the client needs to be kept running until a response is
+	 * received).
+	 */
+	phase_start = app_profile_start();
+	err = golioth_stream_set_sync(s_client, "sensor", GOLIOTH_CONTENT_TYPE_CBOR, cbor_buf,
+				      cbor_size, CONFIG_APP_GOLIOTH_STREAM_TIMEOUT_S);
+	app_profile_end(APP_PROFILE_STREAM, phase_start);
+	if (err != GOLIOTH_OK) {
+		LOG_ERR("Failed to send sensor data to Golioth: %d", err);
+#if defined(CONFIG_APP_BACKLOG)
+		app_backlog_store(reading);
+#endif
+		return -EIO;
+	}
+
+	LOG_INF("Sent sensor data to Golioth");
+
+	app_profile_add_tx_bytes(cbor_size);
+
+	app_payload_sent();
+
+#if defined(CONFIG_APP_REPORT_BY_EXCEPTION)
+	record_report(reading);
+#endif
+
+	return 0;
+}
+
+/* This will be called by the main() loop after delays or on button presses */
+/* Do all of your work here! */
+void app_sensors_read_and_stream(void)
+{
+	struct sensor_reading reading;
+	int err;
+
+#if defined(CONFIG_APP_OVERLAP_SAMPLING)
+	/* Use the reading taken in the background, if one was started */
+	err = app_sensors_read_finish(&reading);
+	if (err == -EALREADY) {
+		err = app_sensors_read(&reading);
+	}
+#else
+	err = app_sensors_read(&reading);
+#endif
+
+	if (err == 0) {
+		app_sensors_stream(&reading);
 	}
 }
@@ -8,26 +8,75 @@
 #ifndef __APP_SENSORS_H__
 #define __APP_SENSORS_H__
 
+#include <stdint.h>
+
 #include <golioth/client.h>
 
+#include "app_battery.h"
+#include "app_math.h"
+#if defined(CONFIG_APP_WAVES)
+#include "app_waves.h"
+#endif
+
 struct accel_xyz {
-	double x;
-	double y;
-	double z;
+	app_real_t x;
+	app_real_t y;
+	app_real_t z;
+};
+
+struct accel_summary {
+	/* Variance of the unfiltered samples (after outlier rejection) */
+	struct accel_xyz variance;
+	int num_samples;
+	int num_rejected;
+	/* Rate the samples were taken at (the ODR when read from the FIFO) */
+	float sample_rate_hz;
 };
 
 struct tilt_sensor {
-	double pitch_rad;
-	double roll_rad;
+	app_real_t pitch_rad;
+	app_real_t roll_rad;
 };
 
 struct water_level_sensor {
-	double float_length_in;
-	double float_offset_in;
-	double float_height_in;
+	app_real_t float_length_in;
+	app_real_t float_offset_in;
+	app_real_t float_height_in;
+};
+
+/* Uptime of a reading taken at an unknown time (e.g. before a reboot) */
+#define APP_SENSORS_UPTIME_UNKNOWN INT64_MIN
+
+struct sensor_reading {
+	/* System uptime when the reading was taken, or APP_SENSORS_UPTIME_UNKNOWN */
+	int64_t uptime_ms;
+	struct accel_xyz accel;
+	struct accel_summary accel_summary;
+	struct tilt_sensor tilt;
+	struct water_level_sensor water_level;
+	struct battery_status battery;
+#if defined(CONFIG_APP_WAVES)
+	struct wave_summary waves;
+	bool waves_valid;
+#endif
 };
 
 void app_sensors_init(struct golioth_client *client);
+int app_sensors_read(struct sensor_reading *reading);
+int app_sensors_stream(struct sensor_reading *reading);
 void app_sensors_read_and_stream(void);
+#if defined(CONFIG_APP_OVERLAP_SAMPLING)
+/*
+ * Start taking a reading in the background. The result is used by the next
+ * call to app_sensors_read_and_stream(), or can be collected (or discarded,
+ * by passing NULL) with app_sensors_read_finish(), which waits for the
+ * reading to complete. Returns -EALREADY if no reading was started.
+ */
+void app_sensors_read_start(void);
+int app_sensors_read_finish(struct sensor_reading *reading);
+#endif
+#if defined(CONFIG_APP_REPORT_BY_EXCEPTION)
+bool app_sensors_report_needed(const struct sensor_reading *reading);
+#endif
 
 #endif /* __APP_SENSORS_H__ */
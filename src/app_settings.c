@@ -7,11 +7,28 @@
 
 #include "app_settings.h"
 
+#include <ctype.h>
+#include <float.h>
+#include <stddef.h>
+#include <string.h>
+
 #include <golioth/client.h>
 #include <golioth/settings.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
-
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
+#include <zephyr/sys/util.h>
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+#include <zephyr/settings/settings.h>
+#endif
+
+#if defined(CONFIG_APP_HEIGHT_TABLE)
+#include "app_fast_math.h"
+#endif
+#if defined(CONFIG_APP_SCHEDULER)
+#include "app_schedule.h"
+#endif
 #include "main.h"
 
 LOG_MODULE_REGISTER(app_settings, CONFIG_APP_LOG_LEVEL);
@@ -22,34 +39,294 @@ LOG_MODULE_REGISTER(app_settings, CONFIG_APP_LOG_LEVEL);
 #define ACCEL_NUM_SAMPLES_MAX	  INT32_MAX
 #define ACCEL_SAMPLE_DELAY_MS_MIN 0
 #define ACCEL_SAMPLE_DELAY_MS_MAX INT32_MAX
-
+#define REPORT_HEARTBEAT_S_MIN	  0
+#define REPORT_HEARTBEAT_S_MAX	  604800 /* 7 days */
+
+enum app_setting_type {
+	SETTING_TYPE_INT,
+	SETTING_TYPE_FLOAT,
+};
+
+struct app_setting {
+	/* Golioth settings key (the stored key is the lower case name) */
+	const char *name;
+	const char *unit;
+	enum app_setting_type type;
+	/* Location of the value in struct app_settings_snapshot */
+	size_t offset;
+	size_t size;
+	double min;
+	double max;
+	double def;
+	/* Optional settings are not waited for, and keep their default until received */
+	bool optional;
+	/* Called from the Golioth client thread after the value changes */
+	void (*on_change)(void);
+};
+
+#define SETTING(_name, _type, _field, _min, _max, _def, _unit, _optional, _on_change)              \
+	{                                                                                          \
+		.name = _name, .unit = _unit, .type = _type,                                       \
+		.offset = offsetof(struct app_settings_snapshot, _field),                          \
+		.size = SIZEOF_FIELD(struct app_settings_snapshot, _field), .min = _min,           \
+		.max = _max, .def = _def, .optional = _optional, .on_change = _on_change,          \
+	}
+#define SETTING_INT(_name, _field, _min, _max, _def, _unit, _on_change)                            \
+	SETTING(_name, SETTING_TYPE_INT, _field, _min, _max, _def, _unit, false, _on_change)
+#define SETTING_FLOAT(_name, _field, _min, _max, _def, _unit, _on_change)                          \
+	SETTING(_name, SETTING_TYPE_FLOAT, _field, _min, _max, _def, _unit, false, _on_change)
+#define SETTING_INT_OPT(_name, _field, _min, _max, _def, _unit, _on_change)                        \
+	SETTING(_name, SETTING_TYPE_INT, _field, _min, _max, _def, _unit, true, _on_change)
+#define SETTING_FLOAT_OPT(_name, _field, _min, _max, _def, _unit, _on_change)                      \
+	SETTING(_name, SETTING_TYPE_FLOAT, _field, _min, _max, _def, _unit, true, _on_change)
+
+static void on_stream_delay_changed(void);
+static void rebuild_height_table(void);
+
+/* Adding a setting only needs an entry here and a field in the snapshot */
+static const struct app_setting s_settings_table[] = {
+	SETTING_INT("STREAM_DELAY_S", stream_delay_s, STREAM_DELAY_S_MIN, STREAM_DELAY_S_MAX,
+		    CONFIG_APP_STREAM_DELAY_S, "seconds", on_stream_delay_changed),
+	SETTING_FLOAT("FLOAT_LENGTH", float_length_in, -FLT_MAX, FLT_MAX, 0.0, "inches",
+		      rebuild_height_table),
+	SETTING_FLOAT("FLOAT_OFFSET", float_offset_in, -FLT_MAX, FLT_MAX, 0.0, "inches",
+		      rebuild_height_table),
+	SETTING_INT("ACCEL_NUM_SAMPLES", accel_num_samples, ACCEL_NUM_SAMPLES_MIN,
+		    ACCEL_NUM_SAMPLES_MAX, CONFIG_APP_ACCEL_NUM_SAMPLES, "samples", NULL),
+	SETTING_INT("ACCEL_SAMPLE_DELAY_MS", accel_sample_delay_ms, ACCEL_SAMPLE_DELAY_MS_MIN,
+		    ACCEL_SAMPLE_DELAY_MS_MAX, CONFIG_ACCEL_SAMPLE_DELAY_MS, "milliseconds", NULL),
+	SETTING_FLOAT_OPT("ACCEL_PITCH_TOLERANCE_DEG", accel_pitch_tolerance_deg, 0.0, FLT_MAX, 0.0,
+			  "degrees", NULL),
+#if defined(CONFIG_APP_REPORT_BY_EXCEPTION)
+	SETTING_FLOAT_OPT("REPORT_HEIGHT_DEADBAND", report_height_deadband_in, 0.0, FLT_MAX, 0.0,
+			  "inches", NULL),
+	SETTING_FLOAT_OPT("REPORT_SOC_DEADBAND", report_soc_deadband_pct, 0.0, FLT_MAX, 0.0, "%",
+			  NULL),
+	SETTING_INT_OPT("REPORT_HEARTBEAT_S", report_heartbeat_s, REPORT_HEARTBEAT_S_MIN,
+			REPORT_HEARTBEAT_S_MAX, CONFIG_APP_REPORT_HEARTBEAT_S, "seconds", NULL),
+#endif
+};
+
+#define SETTING_COUNT ARRAY_SIZE(s_settings_table)
+
+BUILD_ASSERT(SETTING_COUNT <= 32, "Too many settings for the settings masks");
+
+static struct golioth_client *s_client;
 static struct golioth_settings *s_settings;
-static int32_t s_stream_delay_s = CONFIG_APP_STREAM_DELAY_S;
-static float s_float_length_in = 0.0;
-static float s_float_offset_in = 0.0;
-static int32_t s_accel_num_samples = CONFIG_APP_ACCEL_NUM_SAMPLES;
-static int32_t s_accel_sample_delay_ms = CONFIG_ACCEL_SAMPLE_DELAY_MS;
-static bool s_stream_delay_s_valid = false;
-static bool s_float_length_valid = false;
-static bool s_float_offset_valid = false;
-static bool s_accel_num_samples_valid = false;
-static bool s_accel_sample_delay_ms_valid = false;
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+static uint32_t s_cycles_since_sync;
+#endif
+
+/*
+ * The settings values are double buffered: writers copy the current buffer to
+ * the other one, update it and then increment the generation, which selects
+ * the current buffer. Readers never wait for a writer, they just retry the
+ * copy if the generation changed while they were copying.
+ */
+static struct app_settings_snapshot s_values[2];
+static atomic_t s_generation;
+K_MUTEX_DEFINE(s_write_lock);
+
+/* Bit mask of the settings received from Golioth */
+static atomic_t s_valid_mask;
+
+/* Bit mask of the settings which must be received before the settings are valid */
+static uint32_t s_required_mask;
 
 K_SEM_DEFINE(settings_valid_sem, 0, 1);
 
+void app_settings_snapshot(struct app_settings_snapshot *snapshot)
+{
+	atomic_val_t generation;
+
+	do {
+		generation = atomic_get(&s_generation);
+		*snapshot = s_values[generation & 1];
+		barrier_dmem_fence_full();
+	} while (atomic_get(&s_generation) != generation);
+
+	snapshot->generation = (uint32_t)generation;
+}
+
+/* Returns true if the value changed */
+static bool write_setting(const struct app_setting *setting, const void *value)
+{
+	struct app_settings_snapshot *current;
+	struct app_settings_snapshot *next;
+	atomic_val_t generation;
+	bool changed;
+
+	k_mutex_lock(&s_write_lock, K_FOREVER);
+
+	generation = atomic_get(&s_generation);
+	current = &s_values[generation & 1];
+	changed = memcmp((uint8_t *)current + setting->offset, value, setting->size) != 0;
+	if (changed) {
+		next = &s_values[(generation + 1) & 1];
+		*next = *current;
+		memcpy((uint8_t *)next + setting->offset, value, setting->size);
+		barrier_dmem_fence_full();
+		atomic_inc(&s_generation);
+	}
+
+	k_mutex_unlock(&s_write_lock);
+
+	return changed;
+}
+
+static void write_default_settings(void)
+{
+	for (int i = 0; i < SETTING_COUNT; i++) {
+		const struct app_setting *setting = &s_settings_table[i];
+		int32_t int_value = (int32_t)setting->def;
+		float float_value = (float)setting->def;
+
+		write_setting(setting,
+			      setting->type == SETTING_TYPE_INT ? (void *)&int_value : &float_value);
+	}
+}
+
+static void on_stream_delay_changed(void)
+{
+#if defined(CONFIG_APP_SCHEDULER)
+	struct app_settings_snapshot settings;
+
+	/* Move the next wake to the new cadence without interrupting the cycle */
+	app_settings_snapshot(&settings);
+	app_schedule_set_period(APP_SCHEDULE_MEASURE, settings.stream_delay_s);
+#else
+	wake_system_thread();
+#endif
+}
+
+static void rebuild_height_table(void)
+{
+#if defined(CONFIG_APP_HEIGHT_TABLE)
+	struct app_settings_snapshot settings;
+
+	app_settings_snapshot(&settings);
+	app_height_table_build(settings.float_length_in, settings.float_offset_in);
+#endif
+}
+
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+/*
+ * The last validated value of each setting is stored in the settings
+ * partition, so it can be used immediately after waking up (or booting)
+ * instead of waiting for the settings to be received from Golioth.
+ */
+
+/* Bit mask of the settings with a stored value, and the stored values */
+static uint32_t s_stored_mask;
+static uint32_t s_stored_values[SETTING_COUNT];
+
+static bool key_matches_name(const char *key, const char *name)
+{
+	while (*key && tolower((unsigned char)*name) == *key) {
+		key++;
+		name++;
+	}
+
+	return *key == '\0' && *name == '\0';
+}
+
+static int stored_settings_set(const char *key, size_t len, settings_read_cb read_cb,
+			       void *cb_arg)
+{
+	for (int i = 0; i < SETTING_COUNT; i++) {
+		const struct app_setting *setting = &s_settings_table[i];
+		uint32_t value;
+
+		if (!key_matches_name(key, setting->name)) {
+			continue;
+		}
+
+		if (len != setting->size || len > sizeof(value)) {
+			return -EINVAL;
+		}
+
+		if (read_cb(cb_arg, &value, setting->size) == setting->size) {
+			write_setting(setting, &value);
+			memcpy(&s_stored_values[i], &value, setting->size);
+			s_stored_mask |= BIT(i);
+		}
+
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app_settings, "app/settings", NULL, stored_settings_set, NULL,
+			       NULL);
+
+static void persist_setting(int id, const void *value)
+{
+	const struct app_setting *setting = &s_settings_table[id];
+	char key[SETTINGS_MAX_NAME_LEN + 1];
+	int len;
+	int err;
+
+	/* Only write to flash when the stored value changes */
+	if ((s_stored_mask & BIT(id)) &&
+	    memcmp(&s_stored_values[id], value, setting->size) == 0) {
+		return;
+	}
+
+	len = snprintk(key, sizeof(key), "app/settings/");
+	for (const char *c = setting->name; *c && len < sizeof(key) - 1; c++) {
+		key[len++] = tolower((unsigned char)*c);
+	}
+	key[len] = '\0';
+
+	err = settings_save_one(key, value, setting->size);
+	if (err) {
+		LOG_ERR("Failed to store setting %s: %d", setting->name, err);
+		return;
+	}
+
+	memcpy(&s_stored_values[id], value, setting->size);
+	s_stored_mask |= BIT(id);
+}
+
+static bool app_settings_are_stored(void)
+{
+	return (s_stored_mask & s_required_mask) == s_required_mask;
+}
+
+/* Every setting, including the optional ones, has a stored value */
+static bool app_settings_are_all_stored(void)
+{
+	return s_stored_mask == (uint32_t)BIT64_MASK(SETTING_COUNT);
+}
+
+static void load_stored_settings(void)
+{
+	int err;
+
+	err = settings_subsys_init();
+	if (!err) {
+		err = settings_load_subtree("app/settings");
+	}
+	if (err) {
+		LOG_ERR("Failed to load stored settings: %d", err);
+		return;
+	}
+
+	if (app_settings_are_stored()) {
+		LOG_INF("Loaded stored settings");
+	}
+}
+#endif
+
 bool app_settings_are_valid(void)
 {
-	return s_stream_delay_s_valid && s_float_length_valid && s_float_offset_valid &&
-	       s_accel_num_samples_valid && s_accel_sample_delay_ms_valid;
+	return (atomic_get(&s_valid_mask) & s_required_mask) == s_required_mask;
 }
 
 void app_settings_invalidate(void)
 {
-	s_stream_delay_s_valid = false;
-	s_float_length_valid = false;
-	s_float_offset_valid = false;
-	s_accel_num_samples_valid = false;
-	s_accel_sample_delay_ms_valid = false;
+	atomic_clear(&s_valid_mask);
 	k_sem_reset(&settings_valid_sem);
 }
 
@@ -62,6 +339,13 @@ bool app_settings_wait_for_updates(void)
 		return true;
 	}
 
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+	if (app_settings_are_stored()) {
+		LOG_INF("Using stored settings, updates will be applied when received");
+		return true;
+	}
+#endif
+
 	LOG_INF("Waiting for updated settings...");
 	err = k_sem_take(&settings_valid_sem, K_MSEC(CONFIG_APP_GOLIOTH_SETTINGS_TIMEOUT_MS));
 	if (err == -EAGAIN) {
@@ -76,109 +360,82 @@ bool app_settings_wait_for_updates(void)
 	}
 }
 
-static void validate_settings(void)
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+void app_settings_wait_for_refresh(void)
 {
-	if (app_settings_are_valid()) {
-		k_sem_give(&settings_valid_sem);
+	if (app_settings_are_valid() || !s_settings) {
+		return;
 	}
-}
 
-int32_t get_stream_delay_s(void)
-{
-	return s_stream_delay_s;
-}
-
-float get_float_length_in(void)
-{
-	return s_float_length_in;
-}
+	/*
+	 * With a complete stored set, updates which arrived while streaming
+	 * have already been applied, and later ones are received on the next
+	 * sync, so the radio is not kept on waiting for them.
+	 */
+	if (app_settings_are_all_stored()) {
+		return;
+	}
 
-float get_float_offset_in(void)
-{
-	return s_float_offset_in;
+	/* Any updates received are applied (and stored) by the settings callbacks */
+	if (k_sem_take(&settings_valid_sem, K_MSEC(CONFIG_APP_SETTINGS_REFRESH_TIMEOUT_MS))) {
+		LOG_WRN("Settings were not refreshed, using stored settings");
+	}
 }
+#endif
 
-int32_t get_accel_num_samples(void)
+static void validate_settings(void)
 {
-	return s_accel_num_samples;
+	if (app_settings_are_valid()) {
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+		s_cycles_since_sync = 0;
+#endif
+		k_sem_give(&settings_valid_sem);
+	}
 }
 
-int32_t get_accel_sample_delay_ms(void)
+static enum golioth_settings_status update_setting(const struct app_setting *setting,
+						  const void *new_value)
 {
-	return s_accel_sample_delay_ms;
-}
+	int id = setting - s_settings_table;
 
-static enum golioth_settings_status on_stream_delay_s_setting(int32_t new_value, void *arg)
-{
 	/* Only update if value has changed */
-	if (s_stream_delay_s == new_value) {
-		LOG_DBG("Received STREAM_DELAY_S setting already matches local value.");
+	if (!write_setting(setting, new_value)) {
+		LOG_DBG("Received %s setting already matches local value.", setting->name);
 	} else {
-		s_stream_delay_s = new_value;
-		LOG_INF("Set STREAM_DELAY_S setting to %i seconds", s_stream_delay_s);
-
-		wake_system_thread();
+		if (setting->type == SETTING_TYPE_INT) {
+			LOG_INF("Set %s setting to %i %s", setting->name,
+				*(const int32_t *)new_value, setting->unit);
+		} else {
+			LOG_INF("Set %s setting to %.6f %s", setting->name,
+				(double)*(const float *)new_value, setting->unit);
+		}
+
+		if (setting->on_change) {
+			setting->on_change();
+		}
 	}
-	s_stream_delay_s_valid = true;
+	atomic_or(&s_valid_mask, BIT(id));
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+	persist_setting(id, new_value);
+#endif
 	validate_settings();
 	return GOLIOTH_SETTINGS_SUCCESS;
 }
 
-static enum golioth_settings_status on_float_length_in_setting(float new_value, void *arg)
+static enum golioth_settings_status on_int_setting(int32_t new_value, void *arg)
 {
-	/* Only update if value has changed */
-	if (s_float_length_in == new_value) {
-		LOG_DBG("Received FLOAT_LENGTH setting already matches local value.");
-	} else {
-		s_float_length_in = new_value;
-		LOG_INF("Set FLOAT_LENGTH setting to %.6f inches", (double)s_float_length_in);
-	}
-	s_float_length_valid = true;
-	validate_settings();
-	return GOLIOTH_SETTINGS_SUCCESS;
+	return update_setting(arg, &new_value);
 }
 
-static enum golioth_settings_status on_float_offset_in_setting(float new_value, void *arg)
+static enum golioth_settings_status on_float_setting(float new_value, void *arg)
 {
-	/* Only update if value has changed */
-	if (s_float_offset_in == new_value) {
-		LOG_DBG("Received FLOAT_OFFSET setting already matches local value.");
-	} else {
-		s_float_offset_in = new_value;
-		LOG_INF("Set FLOAT_OFFSET setting to %.6f inches", (double)s_float_offset_in);
-	}
-	s_float_offset_valid = true;
-	validate_settings();
-	return GOLIOTH_SETTINGS_SUCCESS;
-}
+	const struct app_setting *setting = arg;
 
-static enum golioth_settings_status on_accel_num_samples_setting(int32_t new_value, void *arg)
-{
-	/* Only update if value has changed */
-	if (s_accel_num_samples == new_value) {
-		LOG_DBG("Received ACCEL_NUM_SAMPLES setting already matches local value.");
-	} else {
-		s_accel_num_samples = new_value;
-		LOG_INF("Set ACCEL_NUM_SAMPLES setting to %i samples", s_accel_num_samples);
+	if (new_value < setting->min || new_value > setting->max) {
+		return GOLIOTH_SETTINGS_VALUE_OUTSIDE_RANGE;
 	}
-	s_accel_num_samples_valid = true;
-	validate_settings();
-	return GOLIOTH_SETTINGS_SUCCESS;
-}
 
-static enum golioth_settings_status on_accel_sample_delay_ms_setting(int32_t new_value, void *arg)
-{
-	/* Only update if value has changed */
-	if (s_accel_sample_delay_ms == new_value) {
-		LOG_DBG("Received ACCEL_SAMPLE_DELAY_MS setting already matches local value.");
-	} else {
-		s_accel_sample_delay_ms = new_value;
-		LOG_INF("Set ACCEL_SAMPLE_DELAY_MS setting to %i milliseconds",
-			s_accel_sample_delay_ms);
-	}
-	s_accel_sample_delay_ms_valid = true;
-	validate_settings();
-	return GOLIOTH_SETTINGS_SUCCESS;
+	return update_setting(setting, &new_value);
 }
 
 static void check_register_settings_error_and_log(int err, const char *settings_str)
@@ -191,38 +448,73 @@ static void check_register_settings_error_and_log(int err, const char *settings_
 	LOG_ERR("Failed to register settings callback for %s: %d", settings_str, err);
 }
 
-void app_settings_init(struct golioth_client *client)
+static void register_settings(void)
 {
 	int err;
 
-	if (s_settings) {
+	s_settings = golioth_settings_init(s_client);
+
+	for (int i = 0; i < SETTING_COUNT; i++) {
+		const struct app_setting *setting = &s_settings_table[i];
+
+		if (setting->type == SETTING_TYPE_INT) {
+			err = golioth_settings_register_int_with_range(
+				s_settings, setting->name, (int32_t)setting->min,
+				(int32_t)setting->max, on_int_setting, (void *)setting);
+		} else {
+			err = golioth_settings_register_float(s_settings, setting->name,
+							      on_float_setting, (void *)setting);
+		}
+		check_register_settings_error_and_log(err, setting->name);
+	}
+}
+
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+bool app_settings_sync_due(void)
+{
+	if (!app_settings_are_stored()) {
+		return true;
+	}
+
+	return ++s_cycles_since_sync >= CONFIG_APP_SETTINGS_SYNC_INTERVAL;
+}
+
+void app_settings_sync_enable(bool enable)
+{
+	if (enable && !s_settings) {
+		LOG_INF("Enabling settings sync");
+		register_settings();
+	} else if (!enable && s_settings) {
+		LOG_INF("Disabling settings sync, using stored settings");
 		golioth_settings_deinit(s_settings);
+		s_settings = NULL;
 	}
+}
+#endif
 
-	app_settings_invalidate();
+void app_settings_init(struct golioth_client *client)
+{
+	if (s_settings) {
+		golioth_settings_deinit(s_settings);
+	}
 
-	s_settings = golioth_settings_init(client);
+	s_client = client;
 
-	err = golioth_settings_register_int_with_range(s_settings, "STREAM_DELAY_S",
-						       STREAM_DELAY_S_MIN, STREAM_DELAY_S_MAX,
-						       on_stream_delay_s_setting, NULL);
-	check_register_settings_error_and_log(err, "STREAM_DELAY_S");
+	s_required_mask = 0;
+	for (int i = 0; i < SETTING_COUNT; i++) {
+		if (!s_settings_table[i].optional) {
+			s_required_mask |= BIT(i);
+		}
+	}
 
-	err = golioth_settings_register_float(s_settings, "FLOAT_LENGTH",
-					      on_float_length_in_setting, NULL);
-	check_register_settings_error_and_log(err, "FLOAT_LENGTH");
+	app_settings_invalidate();
+	write_default_settings();
 
-	err = golioth_settings_register_float(s_settings, "FLOAT_OFFSET",
-					      on_float_offset_in_setting, NULL);
-	check_register_settings_error_and_log(err, "FLOAT_OFFSET");
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+	load_stored_settings();
+#endif
 
-	err = golioth_settings_register_int_with_range(s_settings, "ACCEL_NUM_SAMPLES",
-						       ACCEL_NUM_SAMPLES_MIN, ACCEL_NUM_SAMPLES_MAX,
-						       on_accel_num_samples_setting, NULL);
-	check_register_settings_error_and_log(err, "ACCEL_NUM_SAMPLES");
+	rebuild_height_table();
 
-	err = golioth_settings_register_int_with_range(
-		s_settings, "ACCEL_SAMPLE_DELAY_MS", ACCEL_SAMPLE_DELAY_MS_MIN,
-		ACCEL_SAMPLE_DELAY_MS_MAX, on_accel_sample_delay_ms_setting, NULL);
-	check_register_settings_error_and_log(err, "ACCEL_SAMPLE_DELAY_MS");
+	register_settings();
 }
@@ -13,14 +13,44 @@
 
 #include <golioth/client.h>
 
+/* A copy of all the settings, taken with app_settings_snapshot() */
+struct app_settings_snapshot {
+	/* Incremented each time a setting changes */
+	uint32_t generation;
+	int32_t stream_delay_s;
+	float float_length_in;
+	float float_offset_in;
+	int32_t accel_num_samples;
+	int32_t accel_sample_delay_ms;
+	float accel_pitch_tolerance_deg;
+#if defined(CONFIG_APP_REPORT_BY_EXCEPTION)
+	float report_height_deadband_in;
+	float report_soc_deadband_pct;
+	int32_t report_heartbeat_s;
+#endif
+};
+
 void app_settings_init(struct golioth_client *client);
 bool app_settings_are_valid(void);
 void app_settings_invalidate(void);
 bool app_settings_wait_for_updates(void);
-int32_t get_stream_delay_s(void);
-float get_float_length_in(void);
-float get_float_offset_in(void);
-int32_t get_accel_num_samples(void);
-int32_t get_accel_sample_delay_ms(void);
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+/* Wait (up to CONFIG_APP_SETTINGS_REFRESH_TIMEOUT_MS) for settings updates */
+void app_settings_wait_for_refresh(void);
+/*
+ * Returns true when the settings should be synchronized with Golioth on the
+ * next connection: when a setting has no stored value, or once every
+ * CONFIG_APP_SETTINGS_SYNC_INTERVAL calls. Call once per connection.
+ */
+bool app_settings_sync_due(void);
+/* Register or remove the settings observation; call while the client is stopped */
+void app_settings_sync_enable(bool enable);
+#endif
+/*
+ * Copy the current settings without taking a lock. Every value in the snapshot
+ * comes from the same settings generation, even when the Golioth client thread
+ * updates the settings while they are being copied.
+ */
+void app_settings_snapshot(struct app_settings_snapshot *snapshot);
 
 #endif /* __APP_SETTINGS_H__ */
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_stats.h"
+
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+static void sort_values(app_real_t *values, int count)
+{
+	/* Insertion sort, only used for the first few values */
+	for (int i = 1; i < count; i++) {
+		app_real_t value = values[i];
+		int j = i - 1;
+
+		while (j >= 0 && values[j] > value) {
+			values[j + 1] = values[j];
+			j--;
+		}
+		values[j + 1] = value;
+	}
+}
+
+void app_stats_init(struct app_stats *stats, app_real_t quantile)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->p = quantile;
+}
+
+static app_real_t p2_parabolic(const struct app_stats *stats, int i, int d)
+{
+	const app_real_t *q = stats->q;
+	const int32_t *n = stats->n;
+
+	return q[i] + (app_real_t)d / (app_real_t)(n[i + 1] - n[i - 1]) *
+			      ((app_real_t)(n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) /
+				       (app_real_t)(n[i + 1] - n[i]) +
+			       (app_real_t)(n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) /
+				       (app_real_t)(n[i] - n[i - 1]));
+}
+
+static app_real_t p2_linear(const struct app_stats *stats, int i, int d)
+{
+	const app_real_t *q = stats->q;
+	const int32_t *n = stats->n;
+
+	return q[i] + (app_real_t)d * (q[i + d] - q[i]) / (app_real_t)(n[i + d] - n[i]);
+}
+
+static void p2_init_markers(struct app_stats *stats)
+{
+	app_real_t p = stats->p;
+
+	sort_values(stats->q, APP_STATS_P2_MARKERS);
+
+	for (int i = 0; i < APP_STATS_P2_MARKERS; i++) {
+		stats->n[i] = i;
+	}
+
+	stats->np[0] = APP_REAL(0);
+	stats->np[1] = APP_REAL(2) * p;
+	stats->np[2] = APP_REAL(4) * p;
+	stats->np[3] = APP_REAL(2) + APP_REAL(2) * p;
+	stats->np[4] = APP_REAL(4);
+
+	stats->dn[0] = APP_REAL(0);
+	stats->dn[1] = p / APP_REAL(2);
+	stats->dn[2] = p;
+	stats->dn[3] = (APP_REAL(1) + p) / APP_REAL(2);
+	stats->dn[4] = APP_REAL(1);
+}
+
+static void p2_add(struct app_stats *stats, app_real_t value)
+{
+	app_real_t *q = stats->q;
+	int32_t *n = stats->n;
+	int k;
+
+	/* Find the cell containing the new value, extending the extremes */
+	if (value < q[0]) {
+		q[0] = value;
+		k = 0;
+	} else if (value >= q[4]) {
+		q[4] = value;
+		k = 3;
+	} else {
+		for (k = 0; k < 3; k++) {
+			if (value < q[k + 1]) {
+				break;
+			}
+		}
+	}
+
+	for (int i = k + 1; i < APP_STATS_P2_MARKERS; i++) {
+		n[i]++;
+	}
+
+	for (int i = 0; i < APP_STATS_P2_MARKERS; i++) {
+		stats->np[i] += stats->dn[i];
+	}
+
+	/* Adjust the heights of the middle markers if they are off position */
+	for (int i = 1; i < APP_STATS_P2_MARKERS - 1; i++) {
+		app_real_t d = stats->np[i] - (app_real_t)n[i];
+
+		if ((d >= APP_REAL(1) && (n[i + 1] - n[i]) > 1) ||
+		    (d <= APP_REAL(-1) && (n[i - 1] - n[i]) < -1)) {
+			int ds = (d > APP_REAL(0)) ? 1 : -1;
+			app_real_t qp = p2_parabolic(stats, i, ds);
+
+			if (q[i - 1] < qp && qp < q[i + 1]) {
+				q[i] = qp;
+			} else {
+				q[i] = p2_linear(stats, i, ds);
+			}
+			n[i] += ds;
+		}
+	}
+}
+
+void app_stats_add(struct app_stats *stats, app_real_t value)
+{
+	app_real_t delta;
+
+	if (stats->count == 0) {
+		stats->min = value;
+		stats->max = value;
+	} else {
+		stats->min = MIN(stats->min, value);
+		stats->max = MAX(stats->max, value);
+	}
+
+	if (stats->count < APP_STATS_P2_MARKERS) {
+		stats->q[stats->count] = value;
+		if (stats->count == APP_STATS_P2_MARKERS - 1) {
+			p2_init_markers(stats);
+		}
+	} else {
+		p2_add(stats, value);
+	}
+
+	stats->count++;
+
+	/* Welford's online mean and variance */
+	delta = value - stats->mean;
+	stats->mean += delta / (app_real_t)stats->count;
+	stats->m2 += delta * (value - stats->mean);
+}
+
+app_real_t app_stats_mean(const struct app_stats *stats)
+{
+	return stats->mean;
+}
+
+app_real_t app_stats_variance(const struct app_stats *stats)
+{
+	if (stats->count < 2) {
+		return APP_REAL(0);
+	}
+
+	return stats->m2 / (app_real_t)(stats->count - 1);
+}
+
+app_real_t app_stats_quantile(const struct app_stats *stats)
+{
+	app_real_t values[APP_STATS_P2_MARKERS];
+	int count = (int)stats->count;
+
+	if (count >= APP_STATS_P2_MARKERS) {
+		return stats->q[2];
+	}
+
+	if (count == 0) {
+		return APP_REAL(0);
+	}
+
+	/* Not enough values for P² yet, so use the exact sample quantile */
+	memcpy(values, stats->q, count * sizeof(values[0]));
+	sort_values(values, count);
+
+	return values[(int)(stats->p * (app_real_t)(count - 1) + APP_REAL(0.5))];
+}
+
+bool app_stats_is_outlier(const struct app_stats *stats, app_real_t value, app_real_t sigma,
+			  uint32_t min_count)
+{
+	app_real_t delta = value - stats->mean;
+
+	if (sigma <= APP_REAL(0) || stats->count < min_count || stats->count < 2) {
+		return false;
+	}
+
+	/* Compare squared values to avoid a sqrt() per sample */
+	return (delta * delta) > (sigma * sigma * app_stats_variance(stats));
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_STATS_H__
+#define __APP_STATS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_math.h"
+
+#define APP_STATS_P2_MARKERS 5
+
+/*
+ * Streaming statistics for a single variable using O(1) memory.
+ *
+ * The mean and variance are updated with Welford's algorithm, and a single
+ * quantile (e.g. the median) is estimated with the P² algorithm (Jain &
+ * Chlamtac, 1985).
+ */
+struct app_stats {
+	uint32_t count;
+	app_real_t mean;
+	app_real_t m2;
+	app_real_t min;
+	app_real_t max;
+	/* P² quantile estimator state */
+	app_real_t p;
+	app_real_t q[APP_STATS_P2_MARKERS];
+	app_real_t np[APP_STATS_P2_MARKERS];
+	app_real_t dn[APP_STATS_P2_MARKERS];
+	int32_t n[APP_STATS_P2_MARKERS];
+};
+
+void app_stats_init(struct app_stats *stats, app_real_t quantile);
+void app_stats_add(struct app_stats *stats, app_real_t value);
+app_real_t app_stats_mean(const struct app_stats *stats);
+app_real_t app_stats_variance(const struct app_stats *stats);
+app_real_t app_stats_quantile(const struct app_stats *stats);
+
+/*
+ * Returns true if value is more than sigma standard deviations away from the
+ * current mean. Values are never treated as outliers until at least
+ * min_count values have been added, or if sigma is not positive.
+ */
+bool app_stats_is_outlier(const struct app_stats *stats, app_real_t value, app_real_t sigma,
+			  uint32_t min_count);
+
+#endif /* __APP_STATS_H__ */
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "app_waves.h"
+
+#include <errno.h>
+#include <math.h>
+
+#include <arm_math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(app_waves, CONFIG_APP_LOG_LEVEL);
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define FFT_SIZE CONFIG_APP_WAVE_FFT_SIZE
+
+BUILD_ASSERT((FFT_SIZE & (FFT_SIZE - 1)) == 0, "FFT size must be a power of two");
+
+static float32_t s_samples[FFT_SIZE];
+static float32_t s_spectrum[FFT_SIZE];
+static int s_num_samples;
+
+void app_waves_reset(void)
+{
+	s_num_samples = 0;
+}
+
+void app_waves_add_sample(float pitch_rad)
+{
+	if (s_num_samples < FFT_SIZE) {
+		s_samples[s_num_samples++] = pitch_rad;
+	}
+}
+
+bool app_waves_is_full(void)
+{
+	return s_num_samples == FFT_SIZE;
+}
+
+int app_waves_analyze(float sample_rate_hz, float float_length_in, struct wave_summary *summary)
+{
+	arm_rfft_fast_instance_f32 rfft;
+	float32_t mean;
+	float32_t window_power = 0.0f;
+	float32_t m0 = 0.0f;
+	float32_t peak_density = 0.0f;
+	int peak_bin = 0;
+	float df = sample_rate_hz / FFT_SIZE;
+	int min_bin = (int)ceilf((CONFIG_APP_WAVE_MIN_FREQ_MHZ / 1000.0f) / df);
+	arm_status status;
+
+	if (!app_waves_is_full()) {
+		return -ENODATA;
+	}
+
+	status = arm_rfft_fast_init_f32(&rfft, FFT_SIZE);
+	if (status != ARM_MATH_SUCCESS) {
+		LOG_ERR("Unable to initialize FFT: %d", status);
+		return -EINVAL;
+	}
+
+	/* Float height relative to the hinge (the offset does not affect waves) */
+	for (int i = 0; i < FFT_SIZE; i++) {
+		s_samples[i] = float_length_in * arm_sin_f32(s_samples[i]);
+	}
+
+	/* Remove the mean water level and apply a Hann window */
+	arm_mean_f32(s_samples, FFT_SIZE, &mean);
+	for (int i = 0; i < FFT_SIZE; i++) {
+		float32_t w = 0.5f - 0.5f * arm_cos_f32(2.0f * (float)M_PI * i / (FFT_SIZE - 1));
+
+		s_samples[i] = (s_samples[i] - mean) * w;
+		window_power += w * w;
+	}
+
+	arm_rfft_fast_f32(&rfft, s_samples, s_spectrum, 0);
+
+	/*
+	 * One-sided power spectral density. s_spectrum holds the DC and Nyquist
+	 * terms in the first two entries, followed by (re, im) pairs.
+	 */
+	for (int k = MAX(min_bin, 1); k < FFT_SIZE / 2; k++) {
+		float32_t re = s_spectrum[2 * k];
+		float32_t im = s_spectrum[2 * k + 1];
+		float32_t density = 2.0f * (re * re + im * im) / (sample_rate_hz * window_power);
+
+		m0 += density * df;
+		if (density > peak_density) {
+			peak_density = density;
+			peak_bin = k;
+		}
+	}
+
+	app_waves_reset();
+
+	if (peak_bin == 0) {
+		return -ENODATA;
+	}
+
+	summary->sig_height_in = 4.0f * sqrtf(m0);
+	summary->peak_period_s = 1.0f / (peak_bin * df);
+	summary->peak_density = peak_density;
+
+	LOG_INF("Waves: Hs: %.2f in, Tp: %.1f s, peak density: %.3f in²/Hz",
+		(double)summary->sig_height_in, (double)summary->peak_period_s,
+		(double)summary->peak_density);
+
+	return 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_WAVES_H__
+#define __APP_WAVES_H__
+
+#include <stdbool.h>
+
+/* Compact sea state summary derived from the float height spectrum */
+struct wave_summary {
+	/* Significant wave height 4 * sqrt(m0) (in inches) */
+	float sig_height_in;
+	/* Period of the spectral peak (in seconds) */
+	float peak_period_s;
+	/* Spectral density at the peak (in in²/Hz) */
+	float peak_density;
+};
+
+/* Discard any captured pitch samples */
+void app_waves_reset(void);
+
+/* Capture a pitch sample, ignored once the capture buffer is full */
+void app_waves_add_sample(float pitch_rad);
+
+/* Returns true once CONFIG_APP_WAVE_FFT_SIZE samples have been captured */
+bool app_waves_is_full(void);
+
+/*
+ * Convert the captured pitch time series to float height, estimate its power
+ * spectral density with a Hann-windowed real FFT, and summarize it.
+ *
+ * Returns -ENODATA if the capture buffer is not full.
+ */
+int app_waves_analyze(float sample_rate_hz, float float_length_in, struct wave_summary *summary);
+
+#endif /* __APP_WAVES_H__ */
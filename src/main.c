@@ -14,7 +14,16 @@
 #include <zephyr/kernel.h>
 #include <zephyr/pm/device.h>
 
+#include "app_backlog.h"
+#include "app_batch.h"
 #include "app_battery.h"
+#include "app_energy.h"
+#include "app_lte_window.h"
+#include "app_profile.h"
+#include "app_rai.h"
+#if defined(CONFIG_APP_SCHEDULER)
+#include "app_schedule.h"
+#endif
 #include "app_sensors.h"
 #include "app_settings.h"
 
@@ -39,9 +48,26 @@ static const struct device *const s_flash_ext_dev = DEVICE_DT_GET(DT_ALIAS(spi_f
 K_SEM_DEFINE(lte_connected_sem, 0, 1);
 K_SEM_DEFINE(golioth_ota_sem, 0, 1);
 
+/* DTLS handshake statistics */
+static uint32_t s_handshake_count;
+static int64_t s_handshake_start_ms;
+static int64_t s_handshake_time_ms;
+#if defined(CONFIG_APP_KEEP_SESSION)
+static int64_t s_session_start_ms;
+#endif
+
+#if defined(CONFIG_APP_SCHEDULER)
+/* Jobs due in the current cycle (all of them in the first cycle) */
+static uint32_t s_due_jobs = BIT_MASK(APP_SCHEDULE_NUM_JOBS);
+#endif
+
 void wake_system_thread(void)
 {
+#if defined(CONFIG_APP_SCHEDULER)
+	app_schedule_trigger(APP_SCHEDULE_MEASURE);
+#else
 	k_wakeup(s_system_thread);
+#endif
 }
 
 #if defined(CONFIG_PM_DEVICE)
@@ -67,7 +93,11 @@ static void on_client_event(struct golioth_client *client, enum golioth_client_e
 {
 	switch (event) {
 	case GOLIOTH_CLIENT_EVENT_CONNECTED:
-		LOG_INF("Golioth client connected");
+		s_handshake_count++;
+		s_handshake_time_ms = k_uptime_get() - s_handshake_start_ms;
+		LOG_INF("Golioth client connected (handshake %u took %lld ms)", s_handshake_count,
+			s_handshake_time_ms);
+		app_profile_record(APP_PROFILE_HANDSHAKE, s_handshake_time_ms * USEC_PER_MSEC);
 		break;
 	case GOLIOTH_CLIENT_EVENT_DISCONNECTED:
 		LOG_INF("Golioth client disconnected");
@@ -97,6 +127,119 @@ static void on_fw_update_state_change(enum golioth_ota_state state, enum golioth
 	}
 }
 
+static bool ota_in_progress(void)
+{
+	return k_sem_count_get(&golioth_ota_sem) != 0;
+}
+
+static int32_t stream_delay_s(void)
+{
+	struct app_settings_snapshot settings;
+
+	app_settings_snapshot(&settings);
+
+	return settings.stream_delay_s;
+}
+
+static void sleep_until_next_cycle(void)
+{
+#if defined(CONFIG_APP_ENERGY)
+	app_energy_cycle_end();
+#endif
+
+#if defined(CONFIG_APP_SCHEDULER)
+	s_due_jobs = app_schedule_wait();
+#else
+	k_sleep(K_SECONDS(stream_delay_s()));
+#endif
+}
+
+#if defined(CONFIG_APP_REPORT_BY_EXCEPTION) || defined(CONFIG_APP_BATCH)
+static bool measure_due(void)
+{
+#if defined(CONFIG_APP_SCHEDULER)
+	return s_due_jobs & BIT(APP_SCHEDULE_MEASURE);
+#else
+	return true;
+#endif
+}
+
+/* Returns true if a connection is needed to receive settings and OTA updates */
+static bool sync_due(void)
+{
+#if defined(CONFIG_APP_SCHEDULER)
+	return s_due_jobs & BIT(APP_SCHEDULE_SYNC);
+#else
+	return false;
+#endif
+}
+
+/*
+ * Returns true if pending readings should be uploaded now, because the modem
+ * is awake anyway (for a Tracking Area Update, or in the PSM active time).
+ */
+static bool flush_due(void)
+{
+#if defined(CONFIG_APP_LTE_WINDOW)
+	bool pending = false;
+
+#if defined(CONFIG_APP_BATCH)
+	pending = !app_batch_is_empty();
+#endif
+#if defined(CONFIG_APP_BACKLOG)
+	pending = pending || !app_backlog_is_empty();
+#endif
+
+	return pending &&
+	       ((s_due_jobs & BIT(APP_SCHEDULE_FLUSH)) || app_lte_window_modem_awake());
+#else
+	return false;
+#endif
+}
+#endif
+
+#if defined(CONFIG_APP_BATCH)
+static bool batch_upload_due(void)
+{
+	if (!app_batch_upload_due()) {
+		return false;
+	}
+
+#if defined(CONFIG_APP_LTE_WINDOW)
+	/* Avoid a separate radio wake shortly before the modem wakes up anyway */
+	if (app_lte_window_tau_soon()) {
+		LOG_INF("Deferring batch upload to the next Tracking Area Update");
+		return false;
+	}
+#endif
+
+	return true;
+}
+#endif
+
+static void client_start(void)
+{
+	s_handshake_start_ms = k_uptime_get();
+#if defined(CONFIG_APP_KEEP_SESSION)
+	s_session_start_ms = s_handshake_start_ms;
+#endif
+	golioth_client_start(s_client);
+}
+
+#if defined(CONFIG_APP_KEEP_SESSION)
+static bool session_expired(void)
+{
+	int64_t session_age_ms = k_uptime_get() - s_session_start_ms;
+
+	/* A session which failed to send will be replaced with a new one */
+	if (!golioth_client_is_connected(s_client)) {
+		return true;
+	}
+
+	return session_age_ms >= ((int64_t)CONFIG_APP_SESSION_MAX_AGE_S * MSEC_PER_SEC);
+}
+#endif
+
 static void golioth_client_init(void)
 {
 #if RUNTIME_PSK_AUTH
@@ -133,10 +276,30 @@ static void golioth_client_init(void)
 
 	/* Initialize app sensors module */
 	app_sensors_init(s_client);
+
+#if defined(CONFIG_APP_BATCH)
+	/* Initialize app batch module */
+	app_batch_init(s_client);
+#endif
+
+#if defined(CONFIG_APP_BACKLOG)
+	/* Initialize app backlog module */
+	app_backlog_init(s_client);
+#endif
 }
 
 static void lte_handler(const struct lte_lc_evt *const evt)
 {
+#if defined(CONFIG_APP_LTE_WINDOW)
+	app_lte_window_event(evt);
+#endif
+#if defined(CONFIG_APP_RAI)
+	app_rai_event(evt);
+#endif
+#if defined(CONFIG_APP_ENERGY)
+	app_energy_lte_event(evt);
+#endif
+
 	switch (evt->type) {
 	case LTE_LC_EVT_NW_REG_STATUS:
 		if ((evt->nw_reg_status == LTE_LC_NW_REG_REGISTERED_HOME) ||
@@ -210,6 +373,11 @@ int main(void)
 	/* Initialize battery monitoring */
 	app_battery_init();
 
+#if defined(CONFIG_APP_ENERGY)
+	/* Start attributing the battery current to the wake cycle phases */
+	app_energy_init();
+#endif
+
 	/* Wait for LTE connection */
 	LOG_INF("Connecting to LTE, this may take some time...");
 	lte_lc_connect_async(lte_handler);
@@ -218,7 +386,75 @@ int main(void)
 	/* Create and start a Golioth Client */
 	golioth_client_init();
 
+#if defined(CONFIG_APP_SCHEDULER)
+	app_schedule_set_period(APP_SCHEDULE_MEASURE, stream_delay_s());
+#if defined(CONFIG_APP_SCHEDULE_SYNC_PERIOD_S)
+	app_schedule_set_period(APP_SCHEDULE_SYNC, CONFIG_APP_SCHEDULE_SYNC_PERIOD_S);
+#endif
+#endif
+
 	while (true) {
+		int64_t cycle_start = app_profile_start();
+		int64_t phase_start;
+
+#if defined(CONFIG_APP_ENERGY)
+		app_energy_set_phase(APP_ENERGY_SAMPLING);
+#endif
+
+#if defined(CONFIG_APP_RAI)
+		/* The RRC connection of a cycle is released after the cycle ends */
+		int64_t rrc_connected_ms = app_rai_rrc_connected_ms();
+
+		LOG_INF("RRC connected time in the last cycle: %lld ms", rrc_connected_ms);
+		app_profile_record(APP_PROFILE_RRC, rrc_connected_ms * USEC_PER_MSEC);
+#endif
+
+#if defined(CONFIG_APP_REPORT_BY_EXCEPTION)
+		/*
+		 * Take the reading before connecting, so the connection (and
+		 * the DTLS handshake) can be skipped entirely if nothing has
+		 * changed. The client keeps running while an OTA update is in
+		 * progress, so it is never skipped in that case.
+		 */
+		struct sensor_reading reading;
+		bool reading_valid = false;
+		bool report = sync_due() || flush_due();
+
+		if (measure_due()) {
+			reading_valid = (app_sensors_read(&reading) == 0);
+			report = report || !reading_valid || app_sensors_report_needed(&reading);
+		}
+
+		if (!report && !ota_in_progress()) {
+			LOG_INF("Reading is within the deadband, skipping report");
+			sleep_until_next_cycle();
+			continue;
+		}
+#elif defined(CONFIG_APP_BATCH)
+		/*
+		 * Store a reading every wake, but only connect once the batch
+		 * is due for upload (or an OTA update is in progress).
+		 */
+		struct sensor_reading reading;
+
+		if (measure_due() && app_sensors_read(&reading) == 0) {
+			app_batch_add(&reading);
+		}
+
+		if (!ota_in_progress() && !sync_due() && !flush_due() && !batch_upload_due()) {
+			sleep_until_next_cycle();
+			continue;
+		}
+#endif
+
+#if defined(CONFIG_APP_OVERLAP_SAMPLING)
+		/*
+		 * Sample the accelerometer while the modem wakes up and the
+		 * connection to Golioth is established, instead of after.
+		 */
+		app_sensors_read_start();
+#endif
+
 #if defined(CONFIG_PM_DEVICE)
 		/* Turn on external SPI flash so it can be used for OTA */
 		spi_flash_resume();
@@ -236,32 +472,111 @@ int main(void)
 		 * consumption because it requires a full DTLS handshake each
 		 * time, but it avoids the need for a frequent keepalive to
 		 * ensure observations for settings and OTA are not missed.
+		 *
+		 * With CONFIG_APP_KEEP_SESSION, the client is instead kept
+		 * running while the device sleeps, and DTLS Connection ID
+		 * allows the session to be used again after waking up
+		 * without a handshake. The session is replaced periodically
+		 * so that the observations are re-registered.
 		 */
+#if defined(CONFIG_APP_ENERGY)
+		app_energy_set_phase(APP_ENERGY_CONNECT);
+#endif
+
+		phase_start = app_profile_start();
 		if (!golioth_client_is_running(s_client)) {
-			golioth_client_start(s_client);
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+			/* Skip the settings exchange unless a sync is due */
+			app_settings_sync_enable(app_settings_sync_due());
+#endif
+			client_start();
 		}
 
 		LOG_INF("Waiting for connection to Golioth...");
 		if (golioth_client_wait_for_connect(s_client,
 						    CONFIG_APP_GOLIOTH_CONNECT_TIMEOUT_MS)) {
+			bool settings_valid;
+
+			app_profile_end(APP_PROFILE_CONNECT, phase_start);
+#if defined(CONFIG_APP_ENERGY)
+			app_energy_set_phase(APP_ENERGY_UPLOAD);
+#endif
+
 			/* Only stream sensor data if settings are valid */
-			if (app_settings_wait_for_updates()) {
+			phase_start = app_profile_start();
+			settings_valid = app_settings_wait_for_updates();
+			app_profile_end(APP_PROFILE_SETTINGS, phase_start);
+
+			if (settings_valid) {
+#if defined(CONFIG_APP_REPORT_BY_EXCEPTION)
+				if (reading_valid) {
+					app_sensors_stream(&reading);
+				}
+#elif defined(CONFIG_APP_BATCH)
+				app_batch_stream();
+#else
 				app_sensors_read_and_stream();
+#endif
+#if defined(CONFIG_APP_BACKLOG)
+				/* Send any readings stored while offline */
+				app_backlog_drain();
+#endif
+#if defined(CONFIG_APP_PROFILE)
+				app_profile_stream(s_client);
+#endif
+#if defined(CONFIG_APP_ENERGY)
+				app_energy_stream(s_client);
+#endif
+#if defined(CONFIG_APP_SETTINGS_PERSIST)
+				/* Give settings updates time to arrive before stopping */
+				app_settings_wait_for_refresh();
+#endif
 			}
 		} else {
 			LOG_ERR("Failed to connect to Golioth");
+#if defined(CONFIG_APP_BACKLOG) && !defined(CONFIG_APP_BATCH)
+			/* Keep the reading in the backlog until the next connection */
+#if defined(CONFIG_APP_REPORT_BY_EXCEPTION)
+			if (reading_valid) {
+				app_backlog_store(&reading);
+			}
+#else
+			app_sensors_read_and_stream();
+#endif
+#endif
 		}
 
-		if (k_sem_count_get(&golioth_ota_sem) == 0) {
+#if defined(CONFIG_APP_OVERLAP_SAMPLING)
+		/* Wait for a reading which was not streamed to finish */
+		app_sensors_read_finish(NULL);
+#endif
+
+		LOG_INF("DTLS handshakes: %u, last handshake: %lld ms", s_handshake_count,
+			s_handshake_time_ms);
+
+		if (!ota_in_progress()) {
 			/* Only stop the client when OTA is in the idle state */
+#if defined(CONFIG_APP_KEEP_SESSION)
+			if (session_expired()) {
+				golioth_client_stop(s_client);
+			}
+#else
 			golioth_client_stop(s_client);
+#endif
 
 #if defined(CONFIG_PM_DEVICE)
 			/* Suspend external flash to save power */
 			spi_flash_suspend();
 #endif
+
+#if defined(CONFIG_APP_RAI)
+			/* Nothing more to send, so PSM can be entered right away */
+			app_rai_release();
+#endif
 		}
 
-		k_sleep(K_SECONDS(get_stream_delay_s()));
+		app_profile_end(APP_PROFILE_CYCLE, cycle_start);
+
+		sleep_until_next_cycle();
 	}
 }
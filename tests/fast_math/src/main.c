@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <math.h>
+
+#include <zephyr/ztest.h>
+
+#include "app_fast_math.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Error bounds documented in app_fast_math.h */
+#define ATAN2_MAX_ERR 2e-6
+#define SIN_MAX_ERR   4e-6
+
+#define FLOAT_LENGTH_IN 100.0f
+#define FLOAT_OFFSET_IN 2.5f
+
+/* FLOAT_LENGTH * (π / (N - 1))² / 8 for the default table size */
+#define HEIGHT_TABLE_MAX_ERR 0.0019
+
+ZTEST(fast_math, test_atan2f_error)
+{
+	double max_err = 0.0;
+
+	/* Points on circles of several radii, covering all octants and the axes */
+	for (int r = 0; r < 4; r++) {
+		float radius = powf(10.0f, (float)(2 * r - 3));
+
+		for (int i = 0; i < 36000; i++) {
+			double angle = -M_PI + (2.0 * M_PI * i) / 36000;
+			float y = radius * (float)sin(angle);
+			float x = radius * (float)cos(angle);
+			double err = fabs((double)app_fast_atan2f(y, x) - atan2((double)y, (double)x));
+
+			/* atan2(±0, x < 0) is ±π, so both ends of the range are the same angle */
+			if (err > M_PI) {
+				err = fabs(err - 2.0 * M_PI);
+			}
+			max_err = MAX(max_err, err);
+		}
+	}
+
+	zassert_true(max_err < ATAN2_MAX_ERR, "max |err| %g rad", max_err);
+	zassert_equal(app_fast_atan2f(0.0f, 0.0f), 0.0f);
+}
+
+ZTEST(fast_math, test_sinf_error)
+{
+	double max_err = 0.0;
+
+	for (int i = -100000; i <= 100000; i++) {
+		float x = (float)(M_PI * i / 100000);
+
+		max_err = MAX(max_err, fabs((double)app_fast_sinf(x) - sin((double)x)));
+	}
+
+	zassert_true(max_err < SIN_MAX_ERR, "max |err| %g", max_err);
+}
+
+ZTEST(fast_math, test_height_table_error)
+{
+	double max_err = 0.0;
+	float height_in;
+
+	app_height_table_build(FLOAT_LENGTH_IN, FLOAT_OFFSET_IN);
+
+	for (int i = -100000; i <= 100000; i++) {
+		float pitch_rad = (float)(M_PI / 2 * i / 100000);
+		double expected_in = FLOAT_LENGTH_IN * sin((double)pitch_rad) + FLOAT_OFFSET_IN;
+
+		zassert_ok(app_height_table_lookup(FLOAT_LENGTH_IN, FLOAT_OFFSET_IN, pitch_rad,
+						   &height_in));
+		max_err = MAX(max_err, fabs((double)height_in - expected_in));
+	}
+
+	zassert_true(max_err < HEIGHT_TABLE_MAX_ERR, "max |err| %g in", max_err);
+
+	/* Pitch values outside [-π/2, π/2] are clamped */
+	zassert_ok(app_height_table_lookup(FLOAT_LENGTH_IN, FLOAT_OFFSET_IN, 2.0f, &height_in));
+	zassert_within(height_in, FLOAT_LENGTH_IN + FLOAT_OFFSET_IN, 1e-4f);
+	zassert_ok(app_height_table_lookup(FLOAT_LENGTH_IN, FLOAT_OFFSET_IN, -2.0f, &height_in));
+	zassert_within(height_in, -FLOAT_LENGTH_IN + FLOAT_OFFSET_IN, 1e-4f);
+}
+
+ZTEST(fast_math, test_height_table_settings)
+{
+	float height_in;
+
+	app_height_table_build(FLOAT_LENGTH_IN, FLOAT_OFFSET_IN);
+
+	/* A table built for other settings is not used */
+	zassert_equal(app_height_table_lookup(FLOAT_LENGTH_IN, 0.0f, 0.0f, &height_in), -ESTALE);
+	zassert_equal(app_height_table_lookup(50.0f, FLOAT_OFFSET_IN, 0.0f, &height_in), -ESTALE);
+
+	/* Rebuilding switches to the new settings */
+	app_height_table_build(50.0f, 0.0f);
+	zassert_equal(app_height_table_lookup(FLOAT_LENGTH_IN, FLOAT_OFFSET_IN, 0.0f, &height_in),
+		      -ESTALE);
+	zassert_ok(app_height_table_lookup(50.0f, 0.0f, (float)(M_PI / 6), &height_in));
+	zassert_within(height_in, 25.0f, 0.001f);
+}
+
+ZTEST_SUITE(fast_math, NULL, NULL, NULL, NULL, NULL);
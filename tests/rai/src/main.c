@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/socket_ncs.h>
+
+#include "app_rai.h"
+#include "mocks.h"
+
+static void rrc_update(enum lte_lc_rrc_mode mode)
+{
+	struct lte_lc_evt evt = {
+		.type = LTE_LC_EVT_RRC_UPDATE,
+		.rrc_mode = mode,
+	};
+
+	app_rai_event(&evt);
+}
+
+/* Stands in for a golioth_stream_set_sync() call sending data over the connection */
+static void stream(int32_t duration_ms)
+{
+	k_sleep(K_MSEC(duration_ms));
+}
+
+static void rai_before(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	/* Start every test idle, with no RRC connected time pending */
+	rrc_update(LTE_LC_RRC_MODE_IDLE);
+	(void)app_rai_rrc_connected_ms();
+
+	mock_reset();
+}
+
+ZTEST(rai, test_release_sends_no_data)
+{
+	zassert_ok(app_rai_release());
+
+	zassert_equal(mock.num_calls, 3);
+	zassert_equal(mock.calls[0], MOCK_SOCKET);
+	zassert_equal(mock.calls[1], MOCK_SETSOCKOPT);
+	zassert_equal(mock.calls[2], MOCK_CLOSE);
+
+	zassert_equal(mock.setsockopt.level, SOL_SOCKET);
+	zassert_equal(mock.setsockopt.optname, SO_RAI);
+	zassert_equal(mock.setsockopt.value, RAI_NO_DATA);
+	zassert_equal(mock.open_fds, 0, "socket not closed");
+}
+
+ZTEST(rai, test_release_after_last_stream)
+{
+	/* A wake cycle as run by main(): connect, stream, stop the client, release */
+	rrc_update(LTE_LC_RRC_MODE_CONNECTED);
+
+	stream(100);
+	stream(250);
+	/* The network may release and re-establish the connection between streams */
+	rrc_update(LTE_LC_RRC_MODE_IDLE);
+	rrc_update(LTE_LC_RRC_MODE_CONNECTED);
+	stream(50);
+
+	zassert_equal(mock.num_setsockopt, 0, "RAI sent before the last stream completed");
+
+	zassert_ok(app_rai_release());
+	zassert_equal(mock.num_setsockopt, 1);
+	zassert_equal(mock.setsockopt.value, RAI_NO_DATA);
+
+	/* The connection being released afterwards does not send it again */
+	rrc_update(LTE_LC_RRC_MODE_IDLE);
+	zassert_equal(mock.num_setsockopt, 1);
+}
+
+ZTEST(rai, test_release_socket_error)
+{
+	mock.socket_errno = ENOMEM;
+
+	zassert_equal(app_rai_release(), -ENOMEM);
+	zassert_equal(mock.num_setsockopt, 0);
+	zassert_equal(mock.num_calls, 1, "closed a socket which was not opened");
+}
+
+ZTEST(rai, test_release_setsockopt_error)
+{
+	mock.setsockopt_errno = EOPNOTSUPP;
+
+	zassert_equal(app_rai_release(), -EOPNOTSUPP);
+	zassert_equal(mock.num_setsockopt, 1);
+	zassert_equal(mock.open_fds, 0, "socket not closed after an error");
+}
+
+ZTEST(rai, test_rrc_time_accumulates)
+{
+	int64_t expected_ms = 0;
+	int64_t start_ms;
+
+	/* Two connections, with the idle time between them not counted */
+	start_ms = k_uptime_get();
+	rrc_update(LTE_LC_RRC_MODE_CONNECTED);
+	stream(200);
+	expected_ms += k_uptime_get() - start_ms;
+	rrc_update(LTE_LC_RRC_MODE_IDLE);
+
+	k_sleep(K_MSEC(300));
+
+	start_ms = k_uptime_get();
+	rrc_update(LTE_LC_RRC_MODE_CONNECTED);
+	stream(100);
+	/* Repeated connected events do not restart the connection */
+	rrc_update(LTE_LC_RRC_MODE_CONNECTED);
+	stream(100);
+	expected_ms += k_uptime_get() - start_ms;
+	rrc_update(LTE_LC_RRC_MODE_IDLE);
+
+	zassert_true(expected_ms >= 400);
+	zassert_equal(app_rai_rrc_connected_ms(), expected_ms);
+
+	/* Reading the total resets it */
+	zassert_equal(app_rai_rrc_connected_ms(), 0);
+}
+
+ZTEST(rai, test_rrc_time_ongoing_connection)
+{
+	int64_t start_ms = k_uptime_get();
+	int64_t read_ms;
+
+	rrc_update(LTE_LC_RRC_MODE_CONNECTED);
+	stream(150);
+
+	/* An ongoing connection is counted up to now ... */
+	read_ms = k_uptime_get();
+	zassert_equal(app_rai_rrc_connected_ms(), read_ms - start_ms);
+
+	/* ... and the rest of it is counted in the next read */
+	stream(50);
+	start_ms = read_ms;
+	read_ms = k_uptime_get();
+	rrc_update(LTE_LC_RRC_MODE_IDLE);
+	zassert_equal(app_rai_rrc_connected_ms(), read_ms - start_ms);
+}
+
+ZTEST(rai, test_other_events_ignored)
+{
+	struct lte_lc_evt evt = {
+		.type = LTE_LC_EVT_PSM_UPDATE,
+	};
+
+	rrc_update(LTE_LC_RRC_MODE_CONNECTED);
+	stream(100);
+	/* The rrc_mode member aliases other events' data, so it must not be used for them */
+	evt.rrc_mode = LTE_LC_RRC_MODE_IDLE;
+	app_rai_event(&evt);
+	stream(100);
+
+	zassert_true(app_rai_rrc_connected_ms() >= 200);
+	zassert_equal(mock.num_calls, 0);
+}
+
+ZTEST_SUITE(rai, NULL, NULL, rai_before, NULL, NULL);
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/net/socket.h>
+
+#include "mocks.h"
+
+#define MOCK_FD 3
+
+struct mock_state mock;
+
+void mock_reset(void)
+{
+	memset(&mock, 0, sizeof(mock));
+}
+
+static void record_call(enum mock_call call)
+{
+	if (mock.num_calls < MOCK_MAX_CALLS) {
+		mock.calls[mock.num_calls] = call;
+	}
+	mock.num_calls++;
+}
+
+int zsock_socket(int family, int type, int proto)
+{
+	record_call(MOCK_SOCKET);
+
+	if (mock.socket_errno) {
+		errno = mock.socket_errno;
+		return -1;
+	}
+
+	mock.open_fds++;
+
+	return MOCK_FD;
+}
+
+int zsock_setsockopt(int sock, int level, int optname, const void *optval, uint32_t optlen)
+{
+	record_call(MOCK_SETSOCKOPT);
+
+	mock.num_setsockopt++;
+	mock.setsockopt.fd = sock;
+	mock.setsockopt.level = level;
+	mock.setsockopt.optname = optname;
+	mock.setsockopt.value = (optlen == sizeof(int)) ? *(const int *)optval : -1;
+
+	if (mock.setsockopt_errno) {
+		errno = mock.setsockopt_errno;
+		return -1;
+	}
+
+	return 0;
+}
+
+int zsock_close(int sock)
+{
+	record_call(MOCK_CLOSE);
+
+	if (sock == MOCK_FD) {
+		mock.open_fds--;
+	}
+
+	return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __MOCKS_H__
+#define __MOCKS_H__
+
+#include <stdbool.h>
+
+#define MOCK_MAX_CALLS 8
+
+enum mock_call {
+	MOCK_SOCKET,
+	MOCK_SETSOCKOPT,
+	MOCK_CLOSE,
+};
+
+struct mock_setsockopt {
+	int fd;
+	int level;
+	int optname;
+	int value;
+};
+
+/* Socket calls made by the code under test, in order */
+struct mock_state {
+	enum mock_call calls[MOCK_MAX_CALLS];
+	int num_calls;
+	struct mock_setsockopt setsockopt;
+	int num_setsockopt;
+	int open_fds;
+	/* errno to fail the next zsock_socket()/zsock_setsockopt() call with */
+	int socket_errno;
+	int setsockopt_errno;
+};
+
+extern struct mock_state mock;
+
+void mock_reset(void);
+
+#endif /* __MOCKS_H__ */
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* The subset of the nRF Connect SDK LTE link control API used by app_rai.c */
+
+#ifndef __MOCK_LTE_LC_H__
+#define __MOCK_LTE_LC_H__
+
+enum lte_lc_evt_type {
+	LTE_LC_EVT_NW_REG_STATUS,
+	LTE_LC_EVT_PSM_UPDATE,
+	LTE_LC_EVT_EDRX_UPDATE,
+	LTE_LC_EVT_RRC_UPDATE,
+};
+
+enum lte_lc_rrc_mode {
+	LTE_LC_RRC_MODE_IDLE,
+	LTE_LC_RRC_MODE_CONNECTED,
+};
+
+struct lte_lc_evt {
+	enum lte_lc_evt_type type;
+	union {
+		enum lte_lc_rrc_mode rrc_mode;
+	};
+};
+
+#endif /* __MOCK_LTE_LC_H__ */
@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* The subset of the Zephyr socket API used by app_rai.c, implemented in mocks.c */
+
+#ifndef __MOCK_SOCKET_H__
+#define __MOCK_SOCKET_H__
+
+#include <stdint.h>
+
+#define AF_INET     1
+#define SOCK_DGRAM  2
+#define IPPROTO_UDP 17
+#define SOL_SOCKET  1
+
+int zsock_socket(int family, int type, int proto);
+int zsock_setsockopt(int sock, int level, int optname, const void *optval, uint32_t optlen);
+int zsock_close(int sock);
+
+#endif /* __MOCK_SOCKET_H__ */
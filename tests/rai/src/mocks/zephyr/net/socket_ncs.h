@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* The nRF Connect SDK socket options used by app_rai.c */
+
+#ifndef __MOCK_SOCKET_NCS_H__
+#define __MOCK_SOCKET_NCS_H__
+
+#define SO_RAI      61
+#define RAI_NO_DATA 1
+
+#endif /* __MOCK_SOCKET_NCS_H__ */
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measures the compression ratio of the batch codec on a recorded trace.
+ *
+ * Usage: codec_bench TRACE.csv [BATCH_SIZE]
+ *
+ * Each line of the trace is one reading, given as comma separated scaled
+ * integer fields in the order of enum packed_field in src/app_payload.c
+ * (Unix time in seconds first). The trace is split into batches of
+ * BATCH_SIZE readings (default 32), and each batch is encoded, decoded with
+ * the reference decoder and checked against the original values.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_codec.h"
+
+#define MAX_READINGS 100000
+#define MAX_FIELDS   32
+#define MAX_LINE     1024
+
+static int64_t s_trace[MAX_READINGS][MAX_FIELDS];
+static int64_t s_decoded[MAX_READINGS * MAX_FIELDS];
+static uint8_t s_buf[MAX_READINGS * MAX_FIELDS * 10];
+
+static int64_t get_field(void *ctx, int index, int field)
+{
+	int64_t(*batch)[MAX_FIELDS] = ctx;
+
+	return batch[index][field];
+}
+
+/* Size of the fields written as plain zigzag varints, for comparison */
+static size_t varint_size(int64_t value)
+{
+	uint64_t zz = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+	size_t size = 1;
+
+	while (zz > 0x7f) {
+		zz >>= 7;
+		size++;
+	}
+
+	return size;
+}
+
+static int read_trace(const char *path, int *num_fields)
+{
+	char line[MAX_LINE];
+	int count = 0;
+	FILE *file;
+
+	file = fopen(path, "r");
+	if (!file) {
+		perror(path);
+		return -1;
+	}
+
+	*num_fields = 0;
+
+	while (count < MAX_READINGS && fgets(line, sizeof(line), file)) {
+		int fields = 0;
+		char *save;
+
+		for (char *tok = strtok_r(line, ",\n", &save); tok && fields < MAX_FIELDS;
+		     tok = strtok_r(NULL, ",\n", &save)) {
+			s_trace[count][fields++] = strtoll(tok, NULL, 10);
+		}
+
+		if (fields == 0) {
+			continue;
+		}
+
+		if (*num_fields == 0) {
+			*num_fields = fields;
+		} else if (fields != *num_fields) {
+			fprintf(stderr, "%s: line %d has %d fields, expected %d\n", path,
+				count + 1, fields, *num_fields);
+			fclose(file);
+			return -1;
+		}
+
+		count++;
+	}
+
+	fclose(file);
+
+	return count;
+}
+
+int main(int argc, char **argv)
+{
+	size_t packed_total = 0;
+	size_t varint_total = 0;
+	int batch_size = 32;
+	int num_fields;
+	int count;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s TRACE.csv [BATCH_SIZE]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (argc > 2) {
+		batch_size = atoi(argv[2]);
+	}
+
+	count = read_trace(argv[1], &num_fields);
+	if (count <= 0 || batch_size <= 0) {
+		return EXIT_FAILURE;
+	}
+
+	for (int start = 0; start < count; start += batch_size) {
+		int n = (count - start < batch_size) ? (count - start) : batch_size;
+		size_t len;
+		int err;
+
+		err = app_codec_encode(get_field, &s_trace[start], n, num_fields, s_buf,
+				       sizeof(s_buf), &len);
+		if (err) {
+			fprintf(stderr, "Failed to encode batch at reading %d: %d\n", start, err);
+			return EXIT_FAILURE;
+		}
+
+		err = app_codec_decode(s_buf, len, n, num_fields, s_decoded);
+		if (err) {
+			fprintf(stderr, "Failed to decode batch at reading %d: %d\n", start, err);
+			return EXIT_FAILURE;
+		}
+
+		for (int i = 0; i < n; i++) {
+			for (int f = 0; f < num_fields; f++) {
+				if (s_decoded[i * num_fields + f] != s_trace[start + i][f]) {
+					fprintf(stderr, "Mismatch at reading %d field %d\n",
+						start + i, f);
+					return EXIT_FAILURE;
+				}
+
+				varint_total += varint_size(s_trace[start + i][f]);
+			}
+		}
+
+		packed_total += len;
+	}
+
+	printf("readings: %d, fields: %d, batch size: %d\n", count, num_fields, batch_size);
+	printf("plain varints: %zu bytes (%.1f bytes/reading)\n", varint_total,
+	       (double)varint_total / count);
+	printf("compressed:    %zu bytes (%.1f bytes/reading), ratio %.2f\n", packed_total,
+	       (double)packed_total / count, (double)varint_total / packed_total);
+
+	return EXIT_SUCCESS;
+}
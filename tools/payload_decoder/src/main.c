@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2025 Common Ground Electronics <https://cgnd.dev>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Checks CBOR sensor payloads against the schema.
+ *
+ * Usage: payload_decode FILE...
+ *
+ * Each file must contain a single payload, as streamed to the Golioth
+ * "sensor" path. The schema type that the payload matches is printed, and
+ * the exit status is non-zero if any payload does not match.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sensor_payload_decode.h"
+
+#define PAYLOAD_MAX_SIZE 65536
+
+static uint8_t s_payload[PAYLOAD_MAX_SIZE];
+
+/* Decoded batches are too large for the stack */
+static struct sensor_payload_v1 s_payload_v1;
+static struct sensor_payload_v2 s_payload_v2;
+static struct sensor_batch_v1 s_batch_v1;
+static struct sensor_batch_v2 s_batch_v2;
+
+static const char *decode_payload(const uint8_t *payload, size_t size)
+{
+	size_t decoded;
+
+	if (cbor_decode_sensor_payload_v2(payload, size, &s_payload_v2, &decoded) == 0 &&
+	    decoded == size) {
+		return "sensor-payload-v2";
+	}
+	if (cbor_decode_sensor_batch_v2(payload, size, &s_batch_v2, &decoded) == 0 &&
+	    decoded == size) {
+		return "sensor-batch-v2";
+	}
+	if (cbor_decode_sensor_payload_v1(payload, size, &s_payload_v1, &decoded) == 0 &&
+	    decoded == size) {
+		return "sensor-payload-v1";
+	}
+	if (cbor_decode_sensor_batch_v1(payload, size, &s_batch_v1, &decoded) == 0 &&
+	    decoded == size) {
+		return "sensor-batch-v1";
+	}
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	int status = EXIT_SUCCESS;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s FILE...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	for (int i = 1; i < argc; i++) {
+		FILE *file = fopen(argv[i], "rb");
+		const char *type;
+		size_t size;
+
+		if (!file) {
+			perror(argv[i]);
+			status = EXIT_FAILURE;
+			continue;
+		}
+
+		size = fread(s_payload, 1, sizeof(s_payload), file);
+		fclose(file);
+
+		type = decode_payload(s_payload, size);
+		if (type) {
+			printf("%s: %s (%zu bytes)\n", argv[i], type, size);
+		} else {
+			printf("%s: does not match the schema (%zu bytes)\n", argv[i], size);
+			status = EXIT_FAILURE;
+		}
+	}
+
+	return status;
+}